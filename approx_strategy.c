@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <errno.h>
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "condor.h"
+#include "util.h"
+
+/*
+ * The duel graph defines a symmetric zero-sum game whose value is 0, where
+ * playing i against j pays 1 if i beats j, -1 if j beats i and 0 otherwise.
+ * Both players run optimistic multiplicative weights against each other,
+ * which is the same as one player against itself.  Optimism, predicting that
+ * the next payoffs will repeat the last change, makes both the last strategy
+ * and the average one converge to optimal strategies, much faster than plain
+ * multiplicative weights.  The gap of a strategy p is the best expected payoff
+ * an opponent can get against it, max_j sum_i A[j][i] p[i], which is 0
+ * exactly for optimal strategies.
+ */
+
+/* Iterations between two evaluations of the strategies, and step size */
+#define APPROX_CHECK 8
+#define APPROX_STEP 1.0
+
+/*
+ * Weights this far below the largest are rounded to 0 rather than left to
+ * become subnormal numbers, which slow multiplications down a lot.
+ */
+#define APPROX_CUT 500.0
+
+static double
+approx_now (void)
+{
+#if _POSIX_C_SOURCE >= 199309L && defined CLOCK_MONOTONIC
+	struct timespec ts;
+	if (clock_gettime (CLOCK_MONOTONIC, &ts) == 0)
+		return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+#endif
+	return (double) clock () / CLOCKS_PER_SEC;
+}
+
+/* Stores in u the payoff of each pure strategy against p */
+static void
+approx_payoffs (const size_t nalt, double ARR_PARAM(u, nalt),
+                const char ARR_PARAM(graph, nalt * nalt),
+                const double ARR_PARAM(p, nalt))
+{
+	size_t i, j;
+	for (i = 0; i < nalt; i++)
+		u[i] = 0.0;
+	/* Row by row without branches, so that the loop vectorizes */
+	for (i = 0; i < nalt; i++) {
+		const char * const row = graph + i * nalt;
+		const double pi = p[i];
+		double acc = 0.0;
+		for (j = 0; j < nalt; j++) {
+			const double beats = (double) (row[j] != 0);
+			acc += beats * p[j];
+			u[j] -= beats * pi;
+		}
+		u[i] += acc;
+	}
+}
+
+static double
+approx_gap (const size_t nalt, double ARR_PARAM(u, nalt),
+            const char ARR_PARAM(graph, nalt * nalt),
+            const double ARR_PARAM(p, nalt))
+{
+	double gap = 0.0;
+	size_t i;
+	approx_payoffs (nalt, u, graph, p);
+	for (i = 0; i < nalt; i++) {
+		if (u[i] > gap)
+			gap = u[i];
+	}
+	return gap;
+}
+
+static void
+approx_keep (const size_t nalt, double ARR_PARAM(u, nalt),
+             const char ARR_PARAM(graph, nalt * nalt),
+             const double ARR_PARAM(p, nalt), double REF(best_gap),
+             double ARR_PARAM(best, nalt))
+{
+	const double g = approx_gap (nalt, u, graph, p);
+	if (g < *best_gap) {
+		*best_gap = g;
+		memcpy (best, p, nalt * sizeof (double));
+	}
+}
+
+/* Unbeaten alternatives, if any, are exactly optimal */
+static struct cdor_strategy
+approx_sources (const size_t nalt, const char ARR_PARAM(graph, nalt * nalt))
+{
+	struct cdor_strategy r = { CDOR_ERROR, { 0 } };
+	cdor_bool * const beaten = zero_allocate(cdor_bool, nalt);
+	size_t nsources = 0, i, j;
+	if (!beaten)
+		return r;
+	for (i = 0; i < nalt; i++) {
+		for (j = 0; j < nalt; j++) {
+			if (graph[i * nalt + j])
+				beaten[j] = true;
+		}
+	}
+	for (i = 0; i < nalt; i++) {
+		if (!beaten[i]) {
+			r.val.pure = i;
+			nsources++;
+		}
+	}
+	if (nsources == 1) {
+		r.type = CDOR_PURE;
+	} else if (nsources > 1) {
+		if ((r.val.mixed = allocate(double, nalt))) {
+			r.type = CDOR_MIXED;
+			for (i = 0; i < nalt; i++)
+				r.val.mixed[i] = beaten[i] ? 0.0
+				                 : 1.0 / (double) nsources;
+		}
+	} else {
+		/* Tells the caller to iterate */
+		r.type = CDOR_SPARSE;
+	}
+	free (beaten);
+	return r;
+}
+
+struct cdor_strategy
+cdor_approx_strategy (const size_t nalt, const char * CDOR_RESTRICT graph,
+                      const double epsilon, const unsigned long max_iter,
+                      const double seconds, double * CDOR_RESTRICT gap)
+{
+	struct cdor_strategy r = { CDOR_ERROR, { 0 } };
+	double *best, *work, *logw, *p, *u, *prev, *sum, *avg;
+	double best_gap = HUGE_VAL, start;
+	unsigned long t;
+	size_t i;
+	if (nalt == 0 || nalt > (size_t) -1 / nalt || graph == NULL
+	    || nalt > (size_t) -1 / 6 / sizeof (double)
+	    || (max_iter == 0 && !(seconds > 0.0))) {
+		set_errno (EINVAL);
+		return r;
+	}
+	start = approx_now ();
+	r = approx_sources (nalt, graph);
+	if (r.type != CDOR_SPARSE) {
+		if (gap && r.type != CDOR_ERROR)
+			*gap = 0.0;
+		return r;
+	}
+	r.type = CDOR_ERROR;
+	if (!(best = allocate(double, nalt)))
+		return r;
+	if (!(work = allocate(double, 6 * nalt))) {
+		free (best);
+		return r;
+	}
+	logw = work;
+	p = logw + nalt;
+	u = p + nalt;
+	prev = u + nalt;
+	sum = prev + nalt;
+	avg = sum + nalt;
+	for (i = 0; i < nalt; i++) {
+		logw[i] = prev[i] = sum[i] = 0.0;
+		p[i] = 1.0 / (double) nalt;
+	}
+	for (t = 1;; t++) {
+		double max = -HUGE_VAL, norm = 0.0;
+		cdor_bool stop;
+		approx_payoffs (nalt, u, graph, p);
+		for (i = 0; i < nalt; i++) {
+			sum[i] += p[i];
+			logw[i] += APPROX_STEP * (2.0 * u[i] - prev[i]);
+			prev[i] = u[i];
+			if (logw[i] > max)
+				max = logw[i];
+		}
+		for (i = 0; i < nalt; i++) {
+			const double d = logw[i] - max;
+			p[i] = d > -APPROX_CUT ? exp (d) : 0.0;
+			norm += p[i];
+		}
+		for (i = 0; i < nalt; i++)
+			p[i] /= norm;
+		stop = t == max_iter
+		       || (seconds > 0.0 && approx_now () - start >= seconds);
+		if (stop || t % APPROX_CHECK == 0) {
+			for (i = 0; i < nalt; i++)
+				avg[i] = sum[i] / (double) t;
+			/* The payoffs are recomputed at the next iteration anyway */
+			approx_keep (nalt, u, graph, avg, &best_gap, best);
+			approx_keep (nalt, u, graph, p, &best_gap, best);
+			stop = stop || best_gap <= epsilon;
+		}
+		if (stop)
+			break;
+	}
+	free (work);
+	r.type = CDOR_MIXED;
+	r.val.mixed = best;
+	if (gap)
+		*gap = best_gap;
+	return r;
+}
+
+/*
+ * Whether the probabilities are nonnegative and add up to 1, up to the
+ * tolerance and to rounding errors in adding them
+ */
+static cdor_bool
+approx_distribution (const struct cdor_strategy REF(s), const size_t nalt,
+                     const double tolerance)
+{
+	const size_t len = s->type == CDOR_MIXED ? nalt : s->val.sparse.len;
+	double total = 0.0;
+	cdor_bool neg = false;
+	size_t i;
+	if (s->type == CDOR_MIXED) {
+		for (i = 0; i < nalt; i++) {
+			neg |= !(s->val.mixed[i] >= 0.0);
+			total += s->val.mixed[i];
+		}
+	} else {
+		for (i = 0; i < len; i++) {
+			neg |= !(s->val.sparse.supp[i].prob >= 0.0);
+			total += s->val.sparse.supp[i].prob;
+		}
+	}
+	return !neg && fabs (total - 1.0)
+	               <= tolerance + (double) len * DBL_EPSILON;
+}
+
+int
+cdor_check_strategy (const size_t nalt, const char * CDOR_RESTRICT graph,
+                     const struct cdor_strategy * CDOR_RESTRICT s,
+                     const double tolerance, double * CDOR_RESTRICT gap)
+{
+	double *u, g = 0.0;
+	size_t i, j;
+	if (nalt == 0 || nalt > (size_t) -1 / nalt || graph == NULL
+	    || (s->type == CDOR_PURE && s->val.pure >= nalt)
+	    || (s->type != CDOR_PURE && s->type != CDOR_MIXED
+	        && s->type != CDOR_SPARSE)) {
+		set_errno (EINVAL);
+		return -1;
+	}
+	if (s->type == CDOR_SPARSE) {
+		for (i = 0; i < s->val.sparse.len; i++) {
+			if (s->val.sparse.supp[i].alt >= nalt) {
+				set_errno (EINVAL);
+				return -1;
+			}
+		}
+	}
+	if (s->type != CDOR_PURE && !approx_distribution (s, nalt, tolerance)) {
+		set_errno (EINVAL);
+		return -1;
+	}
+	if (!(u = allocate(double, nalt)))
+		return -1;
+	if (s->type == CDOR_MIXED) {
+		approx_payoffs (nalt, u, graph, s->val.mixed);
+	} else {
+		/* Only the rows and columns of the support are read */
+		const size_t len = s->type == CDOR_PURE ? 1 : s->val.sparse.len;
+		for (j = 0; j < nalt; j++)
+			u[j] = 0.0;
+		for (i = 0; i < len; i++) {
+			const size_t a = s->type == CDOR_PURE ? s->val.pure
+			                 : s->val.sparse.supp[i].alt;
+			const double q = s->type == CDOR_PURE ? 1.0
+			                 : s->val.sparse.supp[i].prob;
+			const char * const row = graph + a * nalt;
+			for (j = 0; j < nalt; j++) {
+				u[j] += q * ((double) (graph[j * nalt + a] != 0)
+				             - (double) (row[j] != 0));
+			}
+		}
+	}
+	for (j = 0; j < nalt; j++) {
+		if (u[j] > g)
+			g = u[j];
+	}
+	free (u);
+	if (gap)
+		*gap = g;
+	return g <= tolerance;
+}
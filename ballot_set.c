@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "condor.h"
+#include "util.h"
+
+#define SET_MIN_CAP 16
+
+/* Open-addressing hash table of rankings, a zero weight marks a free slot */
+struct cdor_ballot_set {
+	size_t nalt;
+	size_t len;
+	size_t cap;
+	size_t *ranks;
+	size_t *hash;
+	cdor_adv *weight;
+};
+
+static size_t
+set_hash (const size_t nalt, const size_t ARR_PARAM(rank, nalt))
+{
+	size_t h = 2166136261UL, i;
+	for (i = 0; i < nalt; i++)
+		h = (h ^ rank[i]) * 16777619UL;
+	return h ^ h >> 15;
+}
+
+static cdor_bool
+set_alloc (struct cdor_ballot_set REF(s), const size_t cap)
+{
+	if (cap > (size_t) -1 / sizeof (size_t) / s->nalt)
+		return false;
+	if (!(s->ranks = allocate(size_t, cap * s->nalt)))
+		return false;
+	if (!(s->hash = allocate(size_t, cap))) {
+		free (s->ranks);
+		return false;
+	}
+	if (!(s->weight = zero_allocate(cdor_adv, cap))) {
+		free (s->hash);
+		free (s->ranks);
+		return false;
+	}
+	s->cap = cap;
+	return true;
+}
+
+/* Returns the slot holding rank, or the free slot where it belongs */
+static size_t
+set_find (const struct cdor_ballot_set REF(s), const size_t h,
+          const size_t * CDOR_RESTRICT const rank)
+{
+	size_t i = h & (s->cap - 1);
+	while (s->weight[i] != 0
+	       && (s->hash[i] != h
+	           || memcmp (s->ranks + i * s->nalt, rank,
+	                      s->nalt * sizeof (size_t)) != 0))
+		i = (i + 1) & (s->cap - 1);
+	return i;
+}
+
+static cdor_bool
+set_grow (struct cdor_ballot_set REF(s))
+{
+	struct cdor_ballot_set old = *s;
+	size_t i;
+	if (s->cap > (size_t) -1 / 2 || !set_alloc (s, 2 * s->cap)) {
+		*s = old;
+		return false;
+	}
+	for (i = 0; i < old.cap; i++) {
+		size_t j;
+		if (old.weight[i] == 0)
+			continue;
+		j = old.hash[i] & (s->cap - 1);
+		while (s->weight[j] != 0)
+			j = (j + 1) & (s->cap - 1);
+		memcpy (s->ranks + j * s->nalt, old.ranks + i * s->nalt,
+		        s->nalt * sizeof (size_t));
+		s->hash[j] = old.hash[i];
+		s->weight[j] = old.weight[i];
+	}
+	free (old.weight);
+	free (old.hash);
+	free (old.ranks);
+	return true;
+}
+
+struct cdor_ballot_set *
+cdor_ballot_set_new (const size_t nalt)
+{
+	struct cdor_ballot_set *s;
+	if (nalt == 0) {
+		set_errno (EINVAL);
+		return NULL;
+	}
+	if (!(s = allocate(struct cdor_ballot_set, 1)))
+		return NULL;
+	s->nalt = nalt;
+	s->len = 0;
+	if (!set_alloc (s, SET_MIN_CAP)) {
+		free (s);
+		return NULL;
+	}
+	return s;
+}
+
+int
+cdor_ballot_set_add (struct cdor_ballot_set * CDOR_RESTRICT const s,
+                     const size_t * CDOR_RESTRICT const rank,
+                     const cdor_adv weight)
+{
+	const size_t h = set_hash (s->nalt, rank);
+	size_t i;
+	if (weight == 0)
+		return 0;
+	i = set_find (s, h, rank);
+	if (s->weight[i] != 0) {
+		if (s->weight[i] > (cdor_adv) -1 - weight) {
+			set_errno (ERANGE);
+			return -1;
+		}
+		s->weight[i] += weight;
+		return 0;
+	}
+	/* Keep the load factor at most one half */
+	if (2 * (s->len + 1) > s->cap) {
+		if (!set_grow (s))
+			return -1;
+		i = set_find (s, h, rank);
+	}
+	memcpy (s->ranks + i * s->nalt, rank, s->nalt * sizeof (size_t));
+	s->hash[i] = h;
+	s->weight[i] = weight;
+	s->len++;
+	return 0;
+}
+
+size_t
+cdor_ballot_set_size (const struct cdor_ballot_set * const s)
+{
+	return s->len;
+}
+
+void
+cdor_ballot_set_flush (struct cdor_ballot_set * CDOR_RESTRICT const s,
+                       cdor_adv * CDOR_RESTRICT const duels)
+{
+	size_t i;
+	for (i = 0; i < s->cap && s->len > 0; i++) {
+		if (s->weight[i] == 0)
+			continue;
+		cdor_cast_weighted_ranking (s->nalt, duels, s->ranks + i * s->nalt,
+		                            s->weight[i]);
+		s->weight[i] = 0;
+		s->len--;
+	}
+}
+
+void
+cdor_ballot_set_free (struct cdor_ballot_set * const s)
+{
+	if (!s)
+		return;
+	free (s->weight);
+	free (s->hash);
+	free (s->ranks);
+	free (s);
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "condor.h"
+#include "util.h"
+
+#ifdef CDOR_THREADS
+#include <pthread.h>
+#endif
+
+/*
+ * Elections are handed out in chunks worth about BATCH_GRAIN units of work,
+ * an election among n alternatives costing n^3 units.  Tiny elections are
+ * thus grabbed by the hundreds while big ones are grabbed one at a time.
+ *
+ * A single queue is enough here, without per-thread deques and stealing:
+ * every election is known up front and none spawns more work, so sorting
+ * them biggest first already gives what stealing would balance, and the lock
+ * is only taken once per chunk, which the grain keeps rare compared to the
+ * linear programs.
+ */
+#define BATCH_GRAIN ((size_t) 1 << 16)
+#define BATCH_MAX_THREADS 256
+
+struct batch_item {
+	size_t nalt;
+	size_t index;
+	enum cdor_status status;
+};
+
+struct batch {
+	const struct cdor_election *elections;
+	struct cdor_strategy *out;
+	struct batch_item *order;
+	size_t count;
+	size_t next;
+	size_t maxn;
+#ifdef CDOR_THREADS
+	cdor_bool threaded;
+	pthread_mutex_t lock;
+#endif
+};
+
+#ifdef __GNUC__
+__attribute__ ((pure, nonnull (1, 2)))
+#endif
+static int
+batch_compare (const void * const x_arg, const void * const y_arg)
+{
+	const struct batch_item * const x = (const struct batch_item *) x_arg;
+	const struct batch_item * const y = (const struct batch_item *) y_arg;
+	/* Biggest first, so that the last chunks are the cheapest */
+	return (x->nalt < y->nalt) - (x->nalt > y->nalt);
+}
+
+static size_t
+batch_cost (const size_t nalt)
+{
+	return nalt >= 1024 ? BATCH_GRAIN : nalt * nalt * nalt;
+}
+
+static size_t
+batch_grab (struct batch REF(b), size_t REF(first))
+{
+	size_t cost = 0;
+#ifdef CDOR_THREADS
+	if (b->threaded)
+		pthread_mutex_lock (&b->lock);
+#endif
+	*first = b->next;
+	while (b->next < b->count && cost < BATCH_GRAIN)
+		cost += batch_cost (b->order[b->next++].nalt);
+#ifdef CDOR_THREADS
+	if (b->threaded)
+		pthread_mutex_unlock (&b->lock);
+#endif
+	return b->next - *first;
+}
+
+static void *
+batch_worker (void * const arg)
+{
+	struct batch * const b = (struct batch *) arg;
+	/* Scratch shared by every election this worker solves */
+	cdor_bool * const scratch = allocate(cdor_bool, b->maxn);
+	size_t first, len;
+	while ((len = batch_grab (b, &first)) > 0) {
+		size_t k;
+		for (k = first; k < first + len; k++) {
+			const size_t i = b->order[k].index;
+			b->out[i] = cdor_strategy_scratch (b->elections[i].nalt,
+			                                   b->elections[i].graph,
+			                                   scratch,
+			                                   &b->order[k].status);
+		}
+	}
+	free (scratch);
+	return NULL;
+}
+
+static unsigned
+batch_threads (unsigned nthreads, const size_t count)
+{
+#if _POSIX_C_SOURCE >= 200112L && defined _SC_NPROCESSORS_ONLN
+	if (nthreads == 0) {
+		const long ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+		nthreads = ncpu > 0 ? (unsigned) ncpu : 1;
+	}
+#else
+	if (nthreads == 0)
+		nthreads = 1;
+#endif
+	if (nthreads > BATCH_MAX_THREADS)
+		nthreads = BATCH_MAX_THREADS;
+	if (nthreads > count)
+		nthreads = (unsigned) count;
+	return nthreads;
+}
+
+int
+cdor_batch_strategies (const size_t count,
+                       const struct cdor_election * CDOR_RESTRICT elections,
+                       struct cdor_strategy * CDOR_RESTRICT out,
+                       const unsigned nthreads)
+{
+	struct batch b;
+	size_t i, failed = count;
+	enum cdor_status status = CDOR_OK;
+	if (count == 0)
+		return 0;
+	if (!(b.order = allocate(struct batch_item, count)))
+		return -1;
+	b.elections = elections;
+	b.out = out;
+	b.count = count;
+	b.next = 0;
+	b.maxn = 1;
+	for (i = 0; i < count; i++) {
+		b.order[i].nalt = elections[i].nalt;
+		b.order[i].index = i;
+		if (elections[i].nalt > b.maxn)
+			b.maxn = elections[i].nalt;
+	}
+	qsort (b.order, count, sizeof *b.order, batch_compare);
+#ifdef CDOR_THREADS
+	b.threaded = false;
+	{
+		pthread_t thread[BATCH_MAX_THREADS];
+		const unsigned want = batch_threads (nthreads, count);
+		unsigned started = 0;
+		if (want > 1 && pthread_mutex_init (&b.lock, NULL) == 0) {
+			b.threaded = true;
+			while (started + 1 < want
+			       && pthread_create (&thread[started], NULL,
+			                          batch_worker, &b) == 0)
+				started++;
+		}
+		/* The calling thread works too */
+		batch_worker (&b);
+		while (started > 0)
+			pthread_join (thread[--started], NULL);
+		if (b.threaded)
+			pthread_mutex_destroy (&b.lock);
+	}
+#else
+	(void) batch_threads (nthreads, count);
+	batch_worker (&b);
+#endif
+	/* Reports the failure of the first election in the order given */
+	for (i = 0; i < count; i++) {
+		if (b.order[i].status != CDOR_OK && b.order[i].index < failed) {
+			failed = b.order[i].index;
+			status = b.order[i].status;
+		}
+	}
+	free (b.order);
+	if (failed == count)
+		return 0;
+	cdor_status_errno (status);
+	return -1;
+}
@@ -20,17 +20,74 @@
 #include "util.h"
 
 void
-cdor_cast_ballot (const size_t nalt, cdor_adv * CDOR_RESTRICT duels,
-                  int (*ballot) (size_t, size_t))
+cdor_cast_weighted_ballot (const size_t nalt, cdor_adv * CDOR_RESTRICT duels,
+                           int (*ballot) (size_t, size_t),
+                           const cdor_adv weight)
 {
 	size_t i, j;
 	for (i = 1; i < nalt; i++) {
 		for (j = 0; j < i; j++) {
 			const int cmp = ballot (i, j);
 			if (cmp < 0)
-				duels[j * nalt + i]++;
+				duels[j * nalt + i] += weight;
 			else if (cmp > 0)
-				duels[i * nalt + j]++;
+				duels[i * nalt + j] += weight;
 		}
 	}
 }
+
+void
+cdor_cast_ballot (const size_t nalt, cdor_adv * CDOR_RESTRICT duels,
+                  int (*ballot) (size_t, size_t))
+{
+	cdor_cast_weighted_ballot (nalt, duels, ballot, 1);
+}
+
+void
+cdor_cast_weighted_ranking (const size_t nalt, cdor_adv * CDOR_RESTRICT duels,
+                            const size_t * CDOR_RESTRICT rank,
+                            const cdor_adv weight)
+{
+	size_t i, j, worst = 0;
+	for (i = 0; i < nalt; i++) {
+		if (rank[i] > worst)
+			worst = rank[i];
+	}
+	/* Branchless full rows vectorize better than the triangle */
+	for (i = 0; i < nalt; i++) {
+		const size_t ri = rank[i];
+		cdor_adv * const row = duels + i * nalt;
+		/* Alternatives ranked last, like those a truncated ballot
+		 * leaves out, beat nobody */
+		if (ri == worst)
+			continue;
+		for (j = 0; j < nalt; j++)
+			row[j] += weight & -(cdor_adv) (ri < rank[j]);
+	}
+}
+
+void
+cdor_cast_partial_ranking (const size_t nalt, cdor_adv * CDOR_RESTRICT duels,
+                           const size_t len, const size_t * CDOR_RESTRICT alt,
+                           const size_t * CDOR_RESTRICT rank,
+                           const cdor_adv weight)
+{
+	size_t a, b, j;
+	for (a = 0; a < len; a++) {
+		const size_t ra = rank[a];
+		cdor_adv * const row = duels + alt[a] * nalt;
+		/* Every alternative left out is beaten, so the whole row is */
+		for (j = 0; j < nalt; j++)
+			row[j] += weight;
+		/* except for listed ones ranked as well or better, itself too */
+		for (b = 0; b < len; b++)
+			row[alt[b]] -= weight & -(cdor_adv) (rank[b] <= ra);
+	}
+}
+
+void
+cdor_cast_ranking (const size_t nalt, cdor_adv * CDOR_RESTRICT duels,
+                   const size_t * CDOR_RESTRICT rank)
+{
+	cdor_cast_weighted_ranking (nalt, duels, rank, 1);
+}
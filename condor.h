@@ -19,26 +19,160 @@
 
 #ifdef __cplusplus
 #include <cstddef>
+#include <cstdio>
 extern "C" {
 #else
 #include <stddef.h>
+#include <stdio.h>
 #endif
 
+struct cdor_prob
+{
+	size_t alt;
+	double prob;
+};
+
 struct cdor_strategy
 {
-	enum { CDOR_ERROR, CDOR_PURE, CDOR_MIXED } type;
-	union { size_t pure; double *mixed; } val;
+	enum { CDOR_ERROR, CDOR_PURE, CDOR_MIXED, CDOR_SPARSE } type;
+	union {
+		size_t pure;
+		double *mixed;
+		struct { size_t len; struct cdor_prob *supp; } sparse;
+	} val;
+};
+
+/* Why a strategy could not be computed */
+enum cdor_status { CDOR_OK, CDOR_INVALID, CDOR_NOMEM, CDOR_UNSOLVED };
+
+/* Element type and strides in bytes of a duel matrix in foreign memory */
+struct cdor_layout
+{
+	enum {
+		CDOR_U8, CDOR_U16, CDOR_U32, CDOR_U64, CDOR_I32, CDOR_I64, CDOR_F64
+	} type;
+	ptrdiff_t row;
+	ptrdiff_t col;
+};
+
+struct cdor_election
+{
+	size_t nalt;
+	const char *graph;
 };
 
 #if __cplusplus >= 201103L || __STDC_VERSION__ >= 199901L || defined __GNUC__
 typedef unsigned long long cdor_adv;
+typedef long long cdor_margin;
 #else
 typedef unsigned long cdor_adv;
+typedef long cdor_margin;
 #endif
 
 extern void cdor_cast_ballot (size_t, cdor_adv *, int (*) (size_t, size_t));
+extern void cdor_cast_ranking (size_t, cdor_adv *, const size_t *);
+extern void cdor_cast_weighted_ballot (size_t, cdor_adv *,
+                                       int (*) (size_t, size_t), cdor_adv);
+extern void cdor_cast_weighted_ranking (size_t, cdor_adv *, const size_t *,
+                                        cdor_adv);
+extern void cdor_cast_partial_ranking (size_t, cdor_adv *, size_t,
+                                       const size_t *, const size_t *,
+                                       cdor_adv);
+
+struct cdor_ballot_set;
+extern struct cdor_ballot_set *cdor_ballot_set_new (size_t);
+extern int cdor_ballot_set_add (struct cdor_ballot_set *, const size_t *,
+                                cdor_adv);
+extern size_t cdor_ballot_set_size (const struct cdor_ballot_set *);
+extern void cdor_ballot_set_flush (struct cdor_ballot_set *, cdor_adv *);
+extern void cdor_ballot_set_free (struct cdor_ballot_set *);
 extern void cdor_make_duel_graph (size_t, char *, const cdor_adv *);
+extern int cdor_make_strided_graph (size_t, char *, const void *,
+                                    const struct cdor_layout *);
+extern size_t cdor_margin_size (size_t);
+extern void cdor_cast_margin_ballot (size_t, cdor_margin *,
+                                     int (*) (size_t, size_t));
+extern void cdor_cast_margin_ranking (size_t, cdor_margin *, const size_t *,
+                                      cdor_margin);
+extern void cdor_make_margin_graph (size_t, char *, const cdor_margin *);
+extern int cdor_add_duels (size_t, cdor_adv *, const cdor_adv *);
+extern int cdor_subtract_duels (size_t, cdor_adv *, const cdor_adv *);
+extern int cdor_scale_duels (size_t, cdor_adv *, cdor_adv);
 extern struct cdor_strategy cdor_optimal_strategy (size_t, const char *);
+extern struct cdor_strategy cdor_sparse_strategy (size_t, const char *);
+extern enum cdor_status cdor_compute_strategy (size_t, const char *,
+                                               struct cdor_strategy *);
+extern const char *cdor_status_string (enum cdor_status);
+extern struct cdor_strategy cdor_duels_strategy (size_t, const cdor_adv *);
+extern struct cdor_strategy cdor_strided_strategy (size_t, const void *,
+                                                   const struct cdor_layout *);
+extern struct cdor_strategy cdor_approx_strategy (size_t, const char *, double,
+                                                  unsigned long, double,
+                                                  double *);
+extern int cdor_check_strategy (size_t, const char *,
+                                const struct cdor_strategy *, double, double *);
+extern int cdor_batch_strategies (size_t, const struct cdor_election *,
+                                  struct cdor_strategy *, unsigned);
+
+struct cdor_tally;
+extern struct cdor_tally *cdor_tally_new (size_t, const cdor_adv *);
+extern void cdor_tally_ranking (struct cdor_tally *, const size_t *, cdor_adv);
+extern void cdor_tally_partial_ranking (struct cdor_tally *, size_t,
+                                        const size_t *, const size_t *,
+                                        cdor_adv);
+extern const cdor_adv *cdor_tally_duels (const struct cdor_tally *);
+extern size_t cdor_tally_sources (const struct cdor_tally *, size_t *);
+extern struct cdor_strategy cdor_tally_strategy (const struct cdor_tally *);
+extern int cdor_tally_add_duels (struct cdor_tally *, const cdor_adv *);
+extern int cdor_tally_subtract_duels (struct cdor_tally *, const cdor_adv *);
+extern void cdor_tally_free (struct cdor_tally *);
+
+struct cdor_window;
+extern struct cdor_window *cdor_window_new (size_t, size_t);
+extern void cdor_window_ranking (struct cdor_window *, const size_t *,
+                                 cdor_adv);
+extern void cdor_window_partial_ranking (struct cdor_window *, size_t,
+                                         const size_t *, const size_t *,
+                                         cdor_adv);
+extern int cdor_window_add_duels (struct cdor_window *, const cdor_adv *);
+extern void cdor_window_advance (struct cdor_window *);
+extern const struct cdor_tally *cdor_window_tally (const struct cdor_window *);
+extern void cdor_window_free (struct cdor_window *);
+
+struct cdor_sample;
+extern struct cdor_sample *cdor_sample_new (size_t, size_t, double);
+extern int cdor_sample_ranking (struct cdor_sample *, const size_t *);
+extern int cdor_sample_settled (struct cdor_sample *, char *);
+extern size_t cdor_sample_count (const struct cdor_sample *);
+extern void cdor_sample_free (struct cdor_sample *);
+extern int cdor_sample_ballots (size_t, size_t, const size_t *, double,
+                                unsigned long, char *, size_t *);
+
+struct cdor_strategy_cache;
+extern struct cdor_strategy_cache *cdor_strategy_cache_new (size_t);
+extern struct cdor_strategy cdor_cached_strategy (struct cdor_strategy_cache *,
+                                                  size_t, const char *);
+extern void cdor_strategy_cache_stats (struct cdor_strategy_cache *,
+                                       unsigned long *, unsigned long *);
+extern void cdor_strategy_cache_free (struct cdor_strategy_cache *);
+
+extern int cdor_save_duels (FILE *, size_t, const cdor_adv *);
+extern int cdor_save_delta (FILE *, size_t, const cdor_adv *);
+extern cdor_adv *cdor_load_duels (FILE *, size_t *);
+extern int cdor_merge_duels (FILE *, size_t, cdor_adv *);
+extern int cdor_ingest_ballots (FILE *, size_t, cdor_adv *, size_t *);
+#if _POSIX_C_SOURCE >= 200112L
+extern const cdor_adv *cdor_map_duels (int, size_t *);
+extern int cdor_unmap_duels (size_t, const cdor_adv *);
+
+struct cdor_shared;
+extern struct cdor_shared *cdor_shared_open (const char *, size_t, unsigned);
+extern void cdor_shared_ranking (struct cdor_shared *, const size_t *,
+                                 cdor_adv);
+extern void cdor_shared_add_duels (struct cdor_shared *, const cdor_adv *);
+extern int cdor_shared_snapshot (struct cdor_shared *, cdor_adv *);
+extern int cdor_shared_close (struct cdor_shared *);
+#endif
 
 #ifdef __cplusplus
 }
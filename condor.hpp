@@ -17,10 +17,28 @@
 #ifndef CONDOR_HPP_INCLUDED
 #define CONDOR_HPP_INCLUDED
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
+#include <deque>
 #include <functional>
+#include <future>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <random>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -32,12 +50,13 @@ class duel_matrix
 {
 	size_t n;
 	std::vector<uintmax_t> matrix;
+	std::vector<size_t> journal;
 
 	public:
 #if __cplusplus >= 202002L
 	constexpr
 #endif
-	duel_matrix (const size_t n) : n (n), matrix (n * n, 0) {}
+	duel_matrix (const size_t n) : n (n), matrix (n * n, 0), journal () {}
 
 #if __cplusplus >= 202002L
 	constexpr
@@ -58,44 +77,208 @@ class duel_matrix
 #endif
 	size_t size (void) const noexcept { return n; }
 
-	void cast_safe (std::function<int (const size_t, const size_t)> blt) {
-		// requires a side matrix to achieve strong exception guarantee
-		std::vector<uint_fast8_t> add (matrix.size (), 0);
+	void cast_safe (std::function<int (const size_t, const size_t)> blt,
+	                const uintmax_t weight = 1) {
+		// journal of incremented cells, kept across casts to reuse memory
+		journal.clear ();
+		journal.reserve (n > 0 ? n * (n - 1) / 2 : 0);
+		try {
+			for (size_t i = 1; i < n; i++) {
+				for (size_t j = 0; j < i; j++) {
+					const int cmp = blt (i, j);
+					if (cmp == 0)
+						continue;
+					const size_t k = cmp > 0 ? i * n + j : j * n + i;
+					matrix[k] += weight;
+					journal.push_back (k);
+				}
+			}
+		} catch (...) {
+			for (const size_t k : journal)
+				matrix[k] -= weight;
+			throw;
+		}
+	}
+
+#if __cpp_constexpr >= 202207L
+	constexpr
+#endif
+	void cast (std::function<int (const size_t, const size_t)> blt,
+	           const uintmax_t weight = 1) {
 		for (size_t i = 1; i < n; i++) {
 			for (size_t j = 0; j < i; j++) {
 				const int cmp = blt (i, j);
-				if (cmp != 0)
-					++add[cmp > 0 ? i * n + j : j * n + i];
+				if (cmp > 0)
+					matrix[i * n + j] += weight;
+				else if (cmp < 0)
+					matrix[j * n + i] += weight;
 			}
 		}
-		std::transform (matrix.begin (), matrix.end (), add.cbegin (),
-		                matrix.begin (), std::plus<> {});
 	}
 
 #if __cplusplus >= 202002L
 	constexpr
 #endif
-	void cast (std::function<int (const size_t, const size_t)> blt) {
-		for (size_t i = 1; i < n; i++) {
-			for (size_t j = 0; j < i; j++) {
+	const uintmax_t *data (void) const noexcept { return matrix.data (); }
+
+#if __cplusplus >= 202002L
+	constexpr
+#endif
+	uintmax_t *data (void) noexcept { return matrix.data (); }
+
+	// Failed operations leave the matrix unchanged
+	duel_matrix &operator += (const duel_matrix &m) {
+		if (&m == this)
+			return *this *= 2;
+		same_size (m);
+		uintmax_t ovf = 0;
+		for (size_t k = 0; k < matrix.size (); k++) {
+			matrix[k] += m.matrix[k];
+			ovf |= matrix[k] < m.matrix[k];
+		}
+		if (ovf) {
+			for (size_t k = 0; k < matrix.size (); k++)
+				matrix[k] -= m.matrix[k];
+			throw std::overflow_error ("duel count overflow");
+		}
+		return *this;
+	}
+
+	duel_matrix &operator -= (const duel_matrix &m) {
+		same_size (m);
+		uintmax_t ovf = 0;
+		for (size_t k = 0; k < matrix.size (); k++)
+			ovf |= matrix[k] < m.matrix[k];
+		if (ovf)
+			throw std::underflow_error ("duel count underflow");
+		for (size_t k = 0; k < matrix.size (); k++)
+			matrix[k] -= m.matrix[k];
+		return *this;
+	}
+
+	duel_matrix &operator *= (const uintmax_t factor) {
+		const uintmax_t limit = factor ? UINTMAX_MAX / factor : UINTMAX_MAX;
+		uintmax_t ovf = 0;
+		for (const uintmax_t x : matrix)
+			ovf |= x > limit;
+		if (ovf)
+			throw std::overflow_error ("duel count overflow");
+		for (uintmax_t &x : matrix)
+			x *= factor;
+		return *this;
+	}
+
+	friend duel_matrix operator + (duel_matrix l, const duel_matrix &r) {
+		return l += r;
+	}
+
+	friend duel_matrix operator - (duel_matrix l, const duel_matrix &r) {
+		return l -= r;
+	}
+
+	friend duel_matrix operator * (duel_matrix l, const uintmax_t factor) {
+		return l *= factor;
+	}
+
+	private:
+	void same_size (const duel_matrix &m) const {
+		if (m.n != n)
+			throw std::invalid_argument ("duel matrix sizes differ");
+	}
+};
+
+// Signed margins of the strict upper triangle, see cdor_margin_size
+class margin_matrix
+{
+	size_t n;
+	std::vector<cdor_margin> margins;
+
+	friend class preorder_ballot;
+
+#if __cplusplus >= 202002L
+	constexpr
+#endif
+	size_t index (const size_t i, const size_t j) const noexcept {
+		return i * n - i * (i + 1) / 2 + j - i - 1;
+	}
+
+	public:
+	margin_matrix (const size_t n) :
+		n (n), margins (cdor_margin_size (n), 0)
+	{}
+
+	// Number of electors preferring i over j minus the converse
+#if __cplusplus >= 202002L
+	constexpr
+#endif
+	cdor_margin operator () (const size_t i, const size_t j) const {
+		if (i >= n || j >= n)
+			throw std::out_of_range ("alternative out of range");
+		if (i == j)
+			return 0;
+		return i < j ? margins[index (i, j)] : -margins[index (j, i)];
+	}
+
+#if __cplusplus >= 202002L
+	constexpr
+#endif
+	size_t size (void) const noexcept { return n; }
+
+	void cast (std::function<int (const size_t, const size_t)> blt,
+	           const cdor_margin weight = 1) {
+		cdor_margin *m = margins.data ();
+		for (size_t i = 0; i < n; i++) {
+			for (size_t j = i + 1; j < n; j++, m++) {
 				const int cmp = blt (i, j);
 				if (cmp > 0)
-					++matrix[i * n + j];
+					*m += weight;
 				else if (cmp < 0)
-					++matrix[j * n + i];
+					*m -= weight;
 			}
 		}
 	}
 
+	void cast_ranking (const std::vector<size_t> &rank,
+	                   const cdor_margin weight = 1) {
+		if (rank.size () != n)
+			throw std::invalid_argument ("ranking size mismatch");
+		cdor_cast_margin_ranking (n, margins.data (), rank.data (), weight);
+	}
+
 #if __cplusplus >= 202002L
 	constexpr
 #endif
-	const uintmax_t *data (void) const noexcept { return matrix.data (); }
+	const cdor_margin *data (void) const noexcept { return margins.data (); }
+
+#if __cplusplus >= 202002L
+	constexpr
+#endif
+	cdor_margin *data (void) noexcept { return margins.data (); }
 };
 
 class preorder_ballot
 {
-	std::map<size_t, std::pair<uintmax_t, uintmax_t>> ballot;
+	using bounds = std::pair<uintmax_t, uintmax_t>;
+
+	std::map<size_t, bounds> ballot;
+
+	static int compare (const bounds &i, const bounds &j) noexcept {
+		return (i.first > j.second) - (i.second < j.first);
+	}
+
+	// Unranked alternatives have no preference, so only pairs of ranked
+	// ones are visited, in increasing order like the matrices store them
+	template <class F>
+	void for_each_pair (const size_t n, F add) const {
+		const auto end = ballot.lower_bound (n);
+		for (auto i = ballot.cbegin (); i != end; ++i) {
+			for (auto j = std::next (i); j != end; ++j) {
+				const int cmp = compare (i->second, j->second);
+				if (cmp != 0)
+					add (i->first, j->first, cmp);
+			}
+		}
+	}
 
 	public:
 	preorder_ballot (void) : ballot () {}
@@ -105,15 +288,17 @@ class preorder_ballot
 		ballot (b)
 	{}
 
-	void cast_into (duel_matrix &m) const {
-		m.cast ([&](const size_t i, const size_t j) {
-			try {
-				const auto &[ai, bi] = ballot.at (i);
-				const auto &[aj, bj] = ballot.at (j);
-				return (ai > bj) - (bi < aj);
-			} catch (std::out_of_range &e) {
-				return 0;
-			}
+	void cast_into (duel_matrix &m, const uintmax_t weight = 1) const {
+		const size_t n = m.size ();
+		uintmax_t * const a = m.data ();
+		for_each_pair (n, [&](const size_t i, const size_t j, const int cmp) {
+			a[cmp > 0 ? i * n + j : j * n + i] += weight;
+		});
+	}
+
+	void cast_into (margin_matrix &m, const cdor_margin weight = 1) const {
+		for_each_pair (m.n, [&](const size_t i, const size_t j, const int cmp) {
+			m.margins[m.index (i, j)] += cmp > 0 ? weight : -weight;
 		});
 	}
 
@@ -143,28 +328,34 @@ class duel_graph
 	size_t n;
 	std::vector<char> matrix;
 
-	friend strategy;
-
-	CondorStrategy get_tagged_union (void) const noexcept {
-		return cdor_optimal_strategy (n, matrix.data ());
-	}
-
 	public:
 #if __cplusplus >= 202002L
 	constexpr
 #endif
 	duel_graph (const size_t n) : n (n), matrix (n * n, 0) {}
 
-#if __cplusplus >= 202002L
-	constexpr
-#endif
 	duel_graph (const duel_matrix &m) : n (m.size ()), matrix (n * n, 0) {
-		for (size_t i = 0; i < n; ++i) {
-			for (size_t j = 0; j < n; ++j)
-				matrix[i * n + j] |= m (i, j) > m (j, i);
+		if constexpr (sizeof (uintmax_t) == 8) {
+			// Tiled like cdor_make_duel_graph
+			const cdor_layout l = {
+				cdor_layout::CDOR_U64,
+				(ptrdiff_t) (n * sizeof (uintmax_t)),
+				(ptrdiff_t) sizeof (uintmax_t)
+			};
+			cdor_make_strided_graph (n, matrix.data (), m.data (), &l);
+		} else {
+			const uintmax_t * const a = m.data ();
+			for (size_t i = 0; i < n; ++i) {
+				for (size_t j = 0; j < n; ++j)
+					matrix[i * n + j] = a[i * n + j] > a[j * n + i];
+			}
 		}
 	}
 
+	duel_graph (const margin_matrix &m) : n (m.size ()), matrix (n * n, 0) {
+		cdor_make_margin_graph (n, matrix.data (), m.data ());
+	}
+
 #if __cplusplus >= 202002L
 	constexpr
 #endif
@@ -190,44 +381,193 @@ class duel_graph
 	const char *data (void) const noexcept { return matrix.data (); }
 };
 
+// Remembers strategies of graphs, up to relabeling of the alternatives
+class strategy_cache
+{
+	struct deleter {
+		void operator () (cdor_strategy_cache * const c) const noexcept {
+			cdor_strategy_cache_free (c);
+		}
+	};
+
+	std::unique_ptr<cdor_strategy_cache, deleter> cache;
+
+	friend strategy;
+
+	cdor_strategy get_tagged_union (const duel_graph &g) noexcept {
+		errno = 0;
+		return cdor_cached_strategy (cache.get (), g.size (), g.data ());
+	}
+
+	public:
+	explicit strategy_cache (const size_t capacity) :
+		cache (cdor_strategy_cache_new (capacity))
+	{
+		if (capacity == 0)
+			throw std::invalid_argument ("cache capacity must be positive");
+		if (!cache)
+			throw std::bad_alloc ();
+	}
+
+	unsigned long hits (void) const noexcept {
+		unsigned long h;
+		cdor_strategy_cache_stats (cache.get (), &h, nullptr);
+		return h;
+	}
+
+	unsigned long misses (void) const noexcept {
+		unsigned long m;
+		cdor_strategy_cache_stats (cache.get (), nullptr, &m);
+		return m;
+	}
+};
+
+// Duels of the ballots cast in the last epochs, see cdor_window_new
+class duel_window
+{
+	struct deleter {
+		void operator () (cdor_window * const w) const noexcept {
+			cdor_window_free (w);
+		}
+	};
+
+	size_t n;
+	std::unique_ptr<cdor_window, deleter> window;
+
+	friend strategy;
+
+	cdor_strategy get_tagged_union (void) const noexcept {
+		errno = 0;
+		return cdor_tally_strategy (cdor_window_tally (window.get ()));
+	}
+
+	public:
+	duel_window (const size_t n, const size_t epochs) :
+		n (n), window (cdor_window_new (n, epochs))
+	{
+		if (n == 0 || epochs == 0)
+			throw std::invalid_argument ("empty window");
+		if (!window)
+			throw std::bad_alloc ();
+	}
+
+	size_t size (void) const noexcept { return n; }
+
+	void cast_ranking (const std::vector<size_t> &rank,
+	                   const uintmax_t weight = 1) {
+		if (rank.size () != n)
+			throw std::invalid_argument ("ranking size mismatch");
+		cdor_window_ranking (window.get (), rank.data (), weight);
+	}
+
+	// Failures leave the window unchanged
+	void add (const duel_matrix &m) {
+		if (m.size () != n)
+			throw std::invalid_argument ("duel matrix sizes differ");
+		const std::vector<cdor_adv> d (m.data (), m.data () + n * n);
+		if (cdor_window_add_duels (window.get (), d.data ()) != 0)
+			throw std::overflow_error ("duel count overflow");
+	}
+
+	void advance (void) noexcept { cdor_window_advance (window.get ()); }
+
+	duel_matrix duels (void) const {
+		const cdor_adv * const d = cdor_tally_duels (
+			cdor_window_tally (window.get ()));
+		duel_matrix m (n);
+		std::copy (d, d + n * n, m.data ());
+		return m;
+	}
+
+	// The Condorcet winner, if any, in constant time
+	std::optional<size_t> winner (void) const noexcept {
+		size_t w;
+		if (cdor_tally_sources (cdor_window_tally (window.get ()), &w) != 1)
+			return std::nullopt;
+		return w;
+	}
+};
+
 class strategy_error : public std::runtime_error
 {
+	cdor_status s;
+
 	public:
-	strategy_error (void) noexcept :
-		std::runtime_error ("could not solve for optimal strategy")
+	strategy_error (const cdor_status st = CDOR_UNSOLVED) noexcept :
+		std::runtime_error (cdor_status_string (st)), s (st)
 	{}
+
+	cdor_status status (void) const noexcept { return s; }
 };
 
 class strategy
 {
-	std::variant<size_t, std::vector<double>> val;
+	public:
+	using support_type = std::vector<std::pair<size_t, double>>;
+
+	private:
+	size_t n;
+	std::variant<size_t, support_type> val;
 
 	template <class R>
-	static size_t play_mixed (R &rng, const std::vector<double> &vec) {
+	static size_t play_mixed (R &rng, const support_type &supp) {
 		std::uniform_real_distribution<double> dist (0.0, 1.0);
 		double roll = dist (rng);
-		for (size_t i = 0; i < vec.size (); i++) {
-			if (roll < vec[i])
+		for (const auto &[i, p] : supp) {
+			if (roll < p)
 				return i;
-			roll -= vec[i];
+			roll -= p;
 		}
-		return vec.size () - 1;
+		return supp.back ().first;
 	}
 
-	public:
-	strategy (const duel_graph &g) : val () {
-		const CondorStrategy res = g.get_tagged_union ();
-		if (res.type == CondorStrategy::CDOR_ERROR) {
-			throw strategy_error ();
-		} else if (res.type == CondorStrategy::CDOR_PURE) {
+	// Entry points without a status report failures through errno
+	static cdor_status errno_status (void) noexcept {
+		switch (errno) {
+		case EINVAL:
+			return CDOR_INVALID;
+		case ENOMEM:
+			return CDOR_NOMEM;
+		default:
+			return CDOR_UNSOLVED;
+		}
+	}
+
+	strategy (const size_t n, const cdor_strategy res) : n (n), val () {
+		if (res.type == cdor_strategy::CDOR_ERROR) {
+			throw strategy_error (errno_status ());
+		} else if (res.type == cdor_strategy::CDOR_PURE) {
 			val = res.val.pure;
 		} else {
-			val = std::vector<double> (res.val.mixed,
-			                           res.val.mixed + g.size ());
-			std::free (res.val.mixed);
+			const cdor_prob * const supp = res.val.sparse.supp;
+			support_type v (res.val.sparse.len);
+			for (size_t i = 0; i < v.size (); i++)
+				v[i] = std::pair (supp[i].alt, supp[i].prob);
+			std::free (res.val.sparse.supp);
+			val = std::move (v);
 		}
 	}
 
+	static cdor_strategy solve (const duel_graph &g) {
+		cdor_strategy r;
+		const cdor_status s = cdor_compute_strategy (g.size (), g.data (),
+		                                             &r);
+		if (s != CDOR_OK)
+			throw strategy_error (s);
+		return r;
+	}
+
+	public:
+	strategy (const duel_graph &g) : strategy (g.size (), solve (g)) {}
+
+	strategy (const duel_graph &g, strategy_cache &cache) :
+		strategy (g.size (), cache.get_tagged_union (g))
+	{}
+
+	strategy (const duel_window &w) :
+		strategy (w.size (), w.get_tagged_union ())
+	{}
+
 	constexpr
 	bool is_pure (void) const noexcept {
 		return std::holds_alternative<size_t> (val);
@@ -235,23 +575,419 @@ class strategy
 
 	constexpr
 	bool is_mixed (void) const noexcept {
-		return std::holds_alternative<std::vector<double>> (val);
+		return std::holds_alternative<support_type> (val);
+	}
+
+#if __cplusplus >= 202002L
+	constexpr
+#endif
+	size_t size (void) const noexcept { return n; }
+
+	// Alternatives with nonzero probability, sorted by index
+	support_type support (void) const {
+		if (is_pure ())
+			return support_type { { std::get<size_t> (val), 1.0 } };
+		return std::get<support_type> (val);
 	}
 
 #if __cplusplus >= 202002L
 	constexpr
 #endif
 	double operator [] (const size_t i) const {
+		if (i >= n)
+			throw std::out_of_range ("alternative out of range");
 		if (is_pure ())
 			return i == std::get<size_t> (val);
-		return std::get<std::vector<double>> (val).at (i);
+		const support_type &supp = std::get<support_type> (val);
+		const auto it = std::lower_bound (
+			supp.cbegin (), supp.cend (), i,
+			[](const auto &e, const size_t k) { return e.first < k; });
+		return it != supp.cend () && it->first == i ? it->second : 0.0;
+	}
+
+	// Whether no alternative of g gains more than tolerance against this
+	bool is_optimal (const duel_graph &g, const double tolerance = 1e-9)
+		const
+	{
+		if (g.size () != n)
+			throw std::invalid_argument ("graph size differs");
+		const support_type supp = support ();
+		std::vector<cdor_prob> probs (supp.size ());
+		for (size_t i = 0; i < supp.size (); i++)
+			probs[i] = cdor_prob { supp[i].first, supp[i].second };
+		cdor_strategy s;
+		s.type = cdor_strategy::CDOR_SPARSE;
+		s.val.sparse.len = probs.size ();
+		s.val.sparse.supp = probs.data ();
+		errno = 0;
+		const int r = cdor_check_strategy (n, g.data (), &s, tolerance,
+		                                   nullptr);
+		if (r < 0 && errno == EINVAL)
+			throw std::invalid_argument ("not a probability distribution");
+		if (r < 0)
+			throw std::bad_alloc ();
+		return r > 0;
 	}
 
 	template <class R>
 	size_t play (R &rng) const {
 		if (is_pure ())
 			return std::get<size_t> (val);
-		return play_mixed (rng, std::get<std::vector<double>> (val));
+		return play_mixed (rng, std::get<support_type> (val));
+	}
+};
+
+// Philox4x32-10 counter-based generator of Salmon et al.: the output for a
+// counter only depends on the key, so any draw can be computed directly
+class philox
+{
+	std::array<uint32_t, 2> key;
+
+	static void mulhilo (const uint32_t a, const uint32_t b, uint32_t &hi,
+	                     uint32_t &lo) noexcept {
+		const uint64_t p = (uint64_t) a * b;
+		hi = (uint32_t) (p >> 32);
+		lo = (uint32_t) p;
+	}
+
+	public:
+	using result_type = std::array<uint32_t, 4>;
+
+	explicit constexpr philox (const uint64_t seed) noexcept :
+		key { (uint32_t) seed, (uint32_t) (seed >> 32) }
+	{}
+
+	result_type operator () (const uint64_t lo, const uint64_t hi) const
+		noexcept
+	{
+		result_type c = {
+			(uint32_t) lo, (uint32_t) (lo >> 32),
+			(uint32_t) hi, (uint32_t) (hi >> 32)
+		};
+		std::array<uint32_t, 2> k = key;
+		for (int r = 0; r < 10; r++) {
+			uint32_t hi0, lo0, hi1, lo1;
+			mulhilo (0xD2511F53, c[0], hi0, lo0);
+			mulhilo (0xCD9E8D57, c[2], hi1, lo1);
+			c = result_type { hi1 ^ c[1] ^ k[0], lo1, hi0 ^ c[3] ^ k[1], lo0 };
+			k[0] += 0x9E3779B9;
+			k[1] += 0xBB67AE85;
+		}
+		return c;
+	}
+};
+
+// Draws outcomes of a strategy in bulk.  Draw i of a stream uses half of the
+// Philox output for counter (i / 2, stream) and picks an alternative from a
+// Walker alias table, so that it only depends on the seed, the stream and i,
+// whatever the threads and batches the draws are split into.
+class sampler
+{
+	std::vector<size_t> alt;
+	// Column j keeps alt[j] with probability keep[j] / 2^32, else alias[j]
+	std::vector<uint64_t> keep;
+	std::vector<size_t> alias;
+	size_t n;
+
+	size_t pick (const uint32_t u, const uint32_t v) const noexcept {
+		const size_t j = (size_t) (((uint64_t) u * alt.size ()) >> 32);
+		return v < keep[j] ? alt[j] : alias[j];
+	}
+
+	template <class F>
+	void draw (const uint64_t seed, const uint64_t stream, uint64_t first,
+	           const uint64_t count, F out) const {
+		const philox gen (seed);
+		const uint64_t end = first + count;
+		while (first < end) {
+			const philox::result_type r = gen (first / 2, stream);
+			for (unsigned h = first % 2; h < 2 && first < end; h++, first++)
+				out (pick (r[2 * h], r[2 * h + 1]));
+		}
+	}
+
+	public:
+	explicit sampler (const strategy &s) :
+		alt (), keep (), alias (), n (s.size ())
+	{
+		const strategy::support_type supp = s.support ();
+		const size_t k = supp.size ();
+		std::vector<double> scaled (k);
+		std::vector<size_t> small, large;
+		double total = 0.0;
+		for (const auto &e : supp)
+			total += e.second;
+		alt.resize (k);
+		keep.assign (k, (uint64_t) 1 << 32);
+		alias.resize (k);
+		for (size_t j = 0; j < k; j++) {
+			alt[j] = alias[j] = supp[j].first;
+			scaled[j] = supp[j].second * (double) k / total;
+			(scaled[j] < 1.0 ? small : large).push_back (j);
+		}
+		// Vose's method; leftovers only differ from 1 by rounding
+		while (!small.empty () && !large.empty ()) {
+			const size_t lo = small.back (), hi = large.back ();
+			small.pop_back ();
+			keep[lo] = (uint64_t) std::ldexp (scaled[lo], 32);
+			alias[lo] = alt[hi];
+			scaled[hi] -= 1.0 - scaled[lo];
+			if (scaled[hi] < 1.0) {
+				large.pop_back ();
+				small.push_back (hi);
+			}
+		}
+	}
+
+#if __cplusplus >= 202002L
+	constexpr
+#endif
+	size_t size (void) const noexcept { return n; }
+
+	// Writes draws first to first + count - 1 of the stream
+	template <class OutputIt>
+	OutputIt generate (const uint64_t seed, const uint64_t stream,
+	                   const uint64_t first, const uint64_t count,
+	                   OutputIt out) const {
+		draw (seed, stream, first, count, [&](const size_t a) {
+			*out++ = a;
+		});
+		return out;
+	}
+
+	// Counts of each alternative among draws 0 to count - 1 of the stream,
+	// split among threads, 0 meaning one per processor
+	std::vector<uint64_t> histogram (const uint64_t seed,
+	                                 const uint64_t stream,
+	                                 const uint64_t count,
+	                                 unsigned threads = 0) const {
+		if (threads == 0)
+			threads = std::max (std::thread::hardware_concurrency (), 1u);
+		if (count / threads < 1024)
+			threads = 1;
+		std::vector<std::vector<uint64_t>> h (threads,
+		                                      std::vector<uint64_t> (n, 0));
+		const auto run = [&](const unsigned t) {
+			const uint64_t first = count / threads * t;
+			const uint64_t last = t + 1 == threads ? count
+			                      : count / threads * (t + 1);
+			uint64_t * const c = h[t].data ();
+			draw (seed, stream, first, last - first,
+			      [c](const size_t a) { c[a]++; });
+		};
+		std::vector<std::thread> pool;
+		pool.reserve (threads - 1);
+		try {
+			for (unsigned t = 1; t < threads; t++)
+				pool.emplace_back (run, t);
+		} catch (...) {
+			// Threads that could not start are run here instead
+			for (unsigned t = (unsigned) pool.size () + 1; t < threads; t++)
+				run (t);
+		}
+		run (0);
+		for (std::thread &t : pool)
+			t.join ();
+		for (unsigned t = 1; t < threads; t++) {
+			for (size_t a = 0; a < n; a++)
+				h[0][a] += h[t][a];
+		}
+		return std::move (h[0]);
+	}
+};
+
+class strategy_cancelled : public std::runtime_error
+{
+	public:
+	strategy_cancelled (void) noexcept :
+		std::runtime_error ("strategy computation was cancelled")
+	{}
+};
+
+// Computes strategies off the calling thread, coalescing identical graphs
+class strategy_service
+{
+	public:
+	using task = std::function<void (void)>;
+	using executor = std::function<void (task)>;
+
+	private:
+	struct job
+	{
+		duel_graph graph;
+		std::promise<strategy> promise;
+		std::shared_future<strategy> future;
+		std::atomic<size_t> waiters;
+
+		job (const duel_graph &g) :
+			graph (g), promise (), future (promise.get_future ()),
+			waiters (0)
+		{}
+	};
+
+	using key = std::pair<size_t, std::string>;
+
+	// Shared with the tasks so that they may outlive the service
+	struct state
+	{
+		std::mutex lock;
+		std::map<key, std::shared_ptr<job>> pending;
+	};
+
+	// Default executor: a single worker thread, so that the service does
+	// not compete with the caller for processors; the solver itself is
+	// thread safe and other executors may run tasks concurrently
+	class worker
+	{
+		std::mutex lock;
+		std::condition_variable cond;
+		std::deque<task> queue;
+		bool stop;
+		std::thread thread;
+
+		void run (void) {
+			std::unique_lock<std::mutex> l (lock);
+			for (;;) {
+				cond.wait (l, [this] { return stop || !queue.empty (); });
+				if (queue.empty ())
+					return;
+				task t = std::move (queue.front ());
+				queue.pop_front ();
+				l.unlock ();
+				t ();
+				l.lock ();
+			}
+		}
+
+		public:
+		worker (void) :
+			lock (), cond (), queue (), stop (false),
+			thread ([this] { run (); })
+		{}
+
+		~worker (void) {
+			{
+				std::lock_guard<std::mutex> l (lock);
+				stop = true;
+			}
+			cond.notify_one ();
+			thread.join ();
+		}
+
+		void post (task t) {
+			{
+				std::lock_guard<std::mutex> l (lock);
+				queue.push_back (std::move (t));
+			}
+			cond.notify_one ();
+		}
+	};
+
+	std::shared_ptr<state> st;
+	std::unique_ptr<worker> own;
+	executor exec;
+
+	static void run_job (const std::shared_ptr<state> &st,
+	                     const std::shared_ptr<job> &j, const key &k) {
+		bool cancelled;
+		{
+			// Requests join under the lock, so none can after erase
+			std::lock_guard<std::mutex> l (st->lock);
+			const auto it = st->pending.find (k);
+			// Gone if submit gave up on the job, which it then failed
+			if (it == st->pending.end () || it->second != j)
+				return;
+			st->pending.erase (it);
+			cancelled = j->waiters.load () == 0;
+		}
+		if (cancelled) {
+			j->promise.set_exception (
+				std::make_exception_ptr (strategy_cancelled ()));
+			return;
+		}
+		try {
+			j->promise.set_value (strategy (j->graph));
+		} catch (...) {
+			j->promise.set_exception (std::current_exception ());
+		}
+	}
+
+	public:
+	class request
+	{
+		std::shared_ptr<job> j;
+		bool active;
+
+		friend strategy_service;
+
+		// Called with the lock of the service held
+		request (std::shared_ptr<job> shared) :
+			j (std::move (shared)), active (true)
+		{
+			++j->waiters;
+		}
+
+		public:
+		request (const request &) = delete;
+		request &operator = (const request &) = delete;
+
+		request (request &&r) noexcept : j (std::move (r.j)), active (r.active) {
+			r.active = false;
+		}
+
+		~request (void) { cancel (); }
+
+		const std::shared_future<strategy> &future (void) const noexcept {
+			return j->future;
+		}
+
+		strategy get (void) const { return j->future.get (); }
+
+		// The computation is skipped if every request for the same graph
+		// is cancelled before it starts, but cannot be interrupted
+		void cancel (void) noexcept {
+			if (active && j)
+				--j->waiters;
+			active = false;
+		}
+	};
+
+	strategy_service (void) :
+		st (std::make_shared<state> ()), own (new worker ()),
+		exec ([w = own.get ()](task t) { w->post (std::move (t)); })
+	{}
+
+	strategy_service (executor e) :
+		st (std::make_shared<state> ()), own (), exec (std::move (e))
+	{}
+
+	request submit (const duel_graph &g) {
+		key k (g.size (), std::string (g.data (),
+		                               g.data () + g.size () * g.size ()));
+		std::unique_lock<std::mutex> l (st->lock);
+		auto it = st->pending.find (k);
+		const bool fresh = it == st->pending.end ();
+		if (fresh)
+			it = st->pending.emplace (k, std::make_shared<job> (g)).first;
+		const std::shared_ptr<job> j = it->second;
+		request r (j);
+		l.unlock ();
+		if (fresh) {
+			try {
+				exec ([st = st, j, k] { run_job (st, j, k); });
+			} catch (...) {
+				// Requests would otherwise wait for a job never run,
+				// including those that joined it meanwhile
+				l.lock ();
+				it = st->pending.find (k);
+				if (it != st->pending.end () && it->second == j) {
+					st->pending.erase (it);
+					j->promise.set_exception (std::current_exception ());
+				}
+				throw;
+			}
+		}
+		return r;
 	}
 };
 
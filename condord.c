@@ -0,0 +1,777 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Results daemon: holds the advantage graph of one election in memory, tallies
+ * the ballots clients send over a Unix domain socket and answers strategy
+ * queries, solving the election again only when its duel graph changed.
+ * Unlike the library, it needs POSIX.
+ */
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "condor.h"
+#include "condord.h"
+#include "util.h"
+
+#ifdef CDOR_THREADS
+#include <pthread.h>
+#endif
+
+/* Distinct pending ballots that trigger a tally */
+#define DAEMON_FLUSH 4096
+/* Bytes asked for by each read */
+#define DAEMON_READ ((size_t) 1 << 16)
+/* Clients with this many unsent bytes are not read until they catch up */
+#define DAEMON_BACKLOG ((size_t) 1 << 20)
+
+struct buffer {
+	char *data;
+	size_t len;
+	size_t cap;
+};
+
+struct client {
+	int fd;
+	struct buffer in;
+	struct buffer out;
+	/* Bytes of out already sent */
+	size_t sent;
+	/* Waiting for the strategy, with ballots up to seq sent before */
+	cdor_bool waiting;
+	unsigned long seq;
+	/* The strategy just solved answers the first pending request */
+	cdor_bool answer;
+};
+
+struct server {
+	size_t nalt;
+	cdor_adv *duels;
+	/* Ballots received since the last tally, aggregated */
+	struct cdor_ballot_set *pending;
+	size_t *rank;
+	/* Duel graph of the cached strategy, and scratch for the next one */
+	char *graph;
+	char *next;
+	cdor_bool changed;
+	cdor_bool solved;
+	struct cdor_strategy strat;
+	/* Outcome of the last solve, as sent to clients */
+	enum cdor_status status;
+	/* Batches of ballots received, and how many the strategy solving saw */
+	unsigned long seq;
+	unsigned long solve_seq;
+	cdor_bool solving;
+#ifdef CDOR_THREADS
+	pthread_t solver;
+#endif
+	struct client *client;
+	size_t nclients;
+	size_t cap;
+};
+
+static volatile sig_atomic_t daemon_stop, daemon_save;
+
+/*
+ * Signals and the solver write to this pipe, which is polled with the
+ * clients, so that poll cannot miss a signal arriving just before it.
+ */
+static int daemon_wake[2] = { -1, -1 };
+
+static void
+daemon_signal (const int sig)
+{
+	const int saved = errno;
+	if (sig == SIGHUP)
+		daemon_save = 1;
+	else
+		daemon_stop = 1;
+	if (write (daemon_wake[1], "x", 1) < 0) {
+		/* Full: the loop wakes up anyway */
+	}
+	errno = saved;
+}
+
+static uint32_t
+get_u32 (const char * const p)
+{
+	uint32_t x;
+	memcpy (&x, p, sizeof x);
+	return x;
+}
+
+static char *
+put_u32 (char * const p, const uint32_t x)
+{
+	memcpy (p, &x, sizeof x);
+	return p + sizeof x;
+}
+
+/* Makes room for len more bytes and returns where they go */
+static char *
+buffer_reserve (struct buffer REF(b), const size_t len)
+{
+	if (b->cap - b->len < len) {
+		size_t cap = b->cap > 0 ? b->cap : DAEMON_READ;
+		char *data;
+		while (cap - b->len < len)
+			cap *= 2;
+		if (!(data = (char *) realloc (b->data, cap)))
+			return NULL;
+		b->data = data;
+		b->cap = cap;
+	}
+	return b->data + b->len;
+}
+
+static void
+server_tally (struct server REF(s))
+{
+	if (cdor_ballot_set_size (s->pending) > 0) {
+		cdor_ballot_set_flush (s->pending, s->duels);
+		s->changed = true;
+	}
+}
+
+/* Records the outcome of the solve that just ended */
+static void
+server_solved (struct server REF(s))
+{
+	s->solving = false;
+	switch (s->status) {
+	case CDOR_OK:
+		s->solved = true;
+		break;
+	case CDOR_INVALID:
+		break;
+	default:
+		/* Solve again at the next query */
+		s->changed = true;
+	}
+}
+
+#ifdef CDOR_THREADS
+static void *
+server_solver (void * const arg)
+{
+	struct server * const s = (struct server *) arg;
+	s->status = cdor_compute_strategy (s->nalt, s->graph, &s->strat);
+	if (write (daemon_wake[1], "s", 1) < 0) {
+		/* Cannot happen: the loop reads the pipe before each poll */
+	}
+	return NULL;
+}
+#endif
+
+/*
+ * Brings the cached strategy up to date with the ballots and returns true,
+ * or returns false if it is being solved.  The linear programs run in a
+ * thread of their own, so that the other clients are served meanwhile.
+ */
+static cdor_bool
+server_solve (struct server REF(s))
+{
+	char *swap;
+	if (s->solving)
+		return false;
+	server_tally (s);
+	if (!s->changed && s->solved)
+		return true;
+	cdor_make_duel_graph (s->nalt, s->next, s->duels);
+	s->changed = false;
+	/* New ballots often leave the duel graph as it was */
+	if (s->solved && memcmp (s->graph, s->next, s->nalt * s->nalt) == 0)
+		return true;
+	if (s->solved && s->strat.type == CDOR_SPARSE)
+		free (s->strat.val.sparse.supp);
+	s->solved = false;
+	swap = s->graph;
+	s->graph = s->next;
+	s->next = swap;
+	s->solve_seq = s->seq;
+	s->solving = true;
+#ifdef CDOR_THREADS
+	if (pthread_create (&s->solver, NULL, server_solver, s) == 0)
+		return false;
+#endif
+	s->status = cdor_compute_strategy (s->nalt, s->graph, &s->strat);
+	server_solved (s);
+	return true;
+}
+
+static enum cdord_status
+server_strategy_status (const struct server REF(s))
+{
+	switch (s->status) {
+	case CDOR_OK:
+		return CDORD_OK;
+	case CDOR_NOMEM:
+		return CDORD_NOMEM;
+	case CDOR_INVALID:
+		return CDORD_INVALID;
+	default:
+		return CDORD_UNSOLVED;
+	}
+}
+
+/* Counts the ballots in order, stopping at the first that fails */
+static enum cdord_status
+server_ballots (struct server REF(s), const char *p, size_t len,
+                uint32_t REF(counted))
+{
+	const size_t size = 4 * (s->nalt + 1);
+	*counted = 0;
+	if (len % size != 0)
+		return CDORD_INVALID;
+	s->seq++;
+	for (; len > 0; len -= size, p += size) {
+		size_t i;
+		for (i = 0; i < s->nalt; i++)
+			s->rank[i] = get_u32 (p + 4 * (i + 1));
+		errno = 0;
+		if (cdor_ballot_set_add (s->pending, s->rank, get_u32 (p)) != 0)
+			return errno == ERANGE ? CDORD_RANGE : CDORD_NOMEM;
+		++*counted;
+		if (cdor_ballot_set_size (s->pending) >= DAEMON_FLUSH)
+			server_tally (s);
+	}
+	return CDORD_OK;
+}
+
+enum reply {
+	REPLY_SENT,
+	/* The request must be handled again once the strategy is solved */
+	REPLY_WAIT,
+	REPLY_FAIL
+};
+
+/* Appends the reply to a request */
+static enum reply
+server_reply (struct server REF(s), struct client REF(c), const uint32_t op,
+              const char *payload, const size_t len)
+{
+	enum cdord_status status = CDORD_INVALID;
+	size_t size = 4, i;
+	uint32_t counted = 0;
+	char *p;
+	switch (op) {
+	case CDORD_BALLOTS:
+		status = server_ballots (s, payload, len, &counted);
+		size += 4;
+		break;
+	case CDORD_STRATEGY:
+		if (len != 0)
+			break;
+		if (!c->answer && !server_solve (s)) {
+			c->waiting = true;
+			c->seq = s->seq;
+			return REPLY_WAIT;
+		}
+		c->answer = false;
+		if ((status = server_strategy_status (s)) == CDORD_OK)
+			size += 4 + 12 * (s->strat.type == CDOR_PURE ? 1
+			                  : s->strat.val.sparse.len);
+		break;
+	case CDORD_DUELS:
+		if (len == 0) {
+			server_tally (s);
+			status = CDORD_OK;
+			size += 4 + 8 * s->nalt * s->nalt;
+		}
+		break;
+	}
+	/* Only replies to ballots have a result on failure */
+	if (status != CDORD_OK && op != CDORD_BALLOTS)
+		size = 4;
+	if (!(p = buffer_reserve (&c->out, 4 + size)))
+		return REPLY_FAIL;
+	c->out.len += 4 + size;
+	p = put_u32 (p, (uint32_t) size);
+	p = put_u32 (p, (uint32_t) status);
+	if (op == CDORD_BALLOTS) {
+		put_u32 (p, counted);
+		return REPLY_SENT;
+	}
+	if (status != CDORD_OK)
+		return REPLY_SENT;
+	if (op == CDORD_DUELS) {
+		p = put_u32 (p, (uint32_t) s->nalt);
+		for (i = 0; i < s->nalt * s->nalt; i++, p += 8) {
+			const uint64_t x = s->duels[i];
+			memcpy (p, &x, 8);
+		}
+	} else if (s->strat.type == CDOR_PURE) {
+		const double one = 1.0;
+		p = put_u32 (p, 1);
+		p = put_u32 (p, (uint32_t) s->strat.val.pure);
+		memcpy (p, &one, 8);
+	} else {
+		p = put_u32 (p, (uint32_t) s->strat.val.sparse.len);
+		for (i = 0; i < s->strat.val.sparse.len; i++, p += 8) {
+			const struct cdor_prob q = s->strat.val.sparse.supp[i];
+			p = put_u32 (p, (uint32_t) q.alt);
+			memcpy (p, &q.prob, 8);
+		}
+	}
+	return REPLY_SENT;
+}
+
+/*
+ * Answers every complete request received, or only the first one if once is
+ * true, and returns false on a broken one
+ */
+static cdor_bool
+server_process (struct server REF(s), struct client REF(c),
+                const cdor_bool once)
+{
+	size_t pos = 0;
+	cdor_bool ok = true;
+	while (c->in.len - pos >= 8) {
+		const uint32_t size = get_u32 (c->in.data + pos);
+		enum reply r;
+		if (size < 4 || size > CDORD_MAX_REQUEST) {
+			ok = false;
+			break;
+		}
+		if (c->in.len - pos - 4 < size)
+			break;
+		r = server_reply (s, c, get_u32 (c->in.data + pos + 4),
+		                  c->in.data + pos + 8, size - 4);
+		if (r == REPLY_FAIL)
+			ok = false;
+		if (r != REPLY_SENT)
+			break;
+		pos += 4 + (size_t) size;
+		if (once)
+			break;
+	}
+	c->in.len -= pos;
+	memmove (c->in.data, c->in.data + pos, c->in.len);
+	return ok;
+}
+
+/* Sends what it can without blocking, returns false if the client is gone */
+static cdor_bool
+client_flush (struct client REF(c))
+{
+	while (c->sent < c->out.len) {
+		const ssize_t n = write (c->fd, c->out.data + c->sent,
+		                         c->out.len - c->sent);
+		if (n < 0)
+			return errno == EAGAIN || errno == EWOULDBLOCK
+			       || errno == EINTR;
+		c->sent += (size_t) n;
+	}
+	c->out.len = c->sent = 0;
+	return true;
+}
+
+/* Reads once, so that a busy client cannot starve the others */
+static cdor_bool
+client_read (struct server REF(s), struct client REF(c))
+{
+	ssize_t n;
+	if (!buffer_reserve (&c->in, DAEMON_READ))
+		return false;
+	n = read (c->fd, c->in.data + c->in.len, c->in.cap - c->in.len);
+	if (n == 0)
+		return false;
+	if (n < 0)
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+	c->in.len += (size_t) n;
+	return server_process (s, c, false);
+}
+
+static void
+client_close (struct server REF(s), const size_t i)
+{
+	close (s->client[i].fd);
+	free (s->client[i].in.data);
+	free (s->client[i].out.data);
+	s->client[i] = s->client[--s->nclients];
+}
+
+/* Serves fd, which is closed if it cannot be */
+static cdor_bool
+server_add (struct server REF(s), const int fd)
+{
+	struct client *c;
+	if (s->nclients == s->cap) {
+		const size_t cap = s->cap > 0 ? 2 * s->cap : 16;
+		struct client * const grown = (struct client *)
+			realloc (s->client, cap * sizeof *grown);
+		if (!grown) {
+			close (fd);
+			return false;
+		}
+		s->client = grown;
+		s->cap = cap;
+	}
+	if (fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK) != 0) {
+		close (fd);
+		return false;
+	}
+	c = &s->client[s->nclients++];
+	memset (c, 0, sizeof *c);
+	c->fd = fd;
+	return true;
+}
+
+static void
+server_accept (struct server REF(s), const int listener)
+{
+	int fd;
+	while ((fd = accept (listener, NULL, NULL)) >= 0) {
+		if (!server_add (s, fd) && errno == ENOMEM)
+			return;
+	}
+}
+
+static int
+server_listen (const char * const path)
+{
+	struct sockaddr_un addr;
+	struct stat st;
+	int fd;
+	if (strlen (path) >= sizeof addr.sun_path) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	memset (&addr, 0, sizeof addr);
+	addr.sun_family = AF_UNIX;
+	strcpy (addr.sun_path, path);
+	/* A socket left over by a previous run would make bind fail */
+	if (stat (path, &st) == 0 && S_ISSOCK(st.st_mode))
+		unlink (path);
+	if ((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return -1;
+	if (bind (fd, (struct sockaddr *) &addr, sizeof addr) != 0
+	    || listen (fd, SOMAXCONN) != 0
+	    || fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK) != 0) {
+		close (fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* Replaces the snapshot atomically, so that a crash never leaves half of it */
+static int
+server_save (const struct server REF(s), const char * const path)
+{
+	const size_t len = strlen (path);
+	char * const tmp = allocate(char, len + 5);
+	FILE *f;
+	int status = -1;
+	if (!tmp)
+		return -1;
+	memcpy (tmp, path, len);
+	memcpy (tmp + len, ".tmp", 5);
+	if ((f = fopen (tmp, "wb"))) {
+		status = cdor_save_duels (f, s->nalt, s->duels);
+		if (fclose (f) != 0)
+			status = -1;
+		if (status == 0)
+			status = rename (tmp, path);
+		if (status != 0)
+			remove (tmp);
+	}
+	free (tmp);
+	return status;
+}
+
+/*
+ * Answers the clients waiting for the strategy, once it is solved.  Any of
+ * them may start the next solve, which frees the strategy and then writes it
+ * from another thread, so every client it answers gets its reply first.
+ */
+static void
+server_resume (struct server REF(s))
+{
+	size_t i;
+	/* Backwards, since closing moves the last client */
+	for (i = s->nclients; i > 0; i--) {
+		struct client * const c = &s->client[i - 1];
+		/* Others sent ballots the strategy ignores and wait for the next */
+		if (!c->waiting || c->seq > s->solve_seq)
+			continue;
+		c->answer = true;
+		if (!server_process (s, c, true))
+			client_close (s, i - 1);
+	}
+	for (i = s->nclients; i > 0; i--) {
+		struct client * const c = &s->client[i - 1];
+		cdor_bool ok;
+		if (!c->waiting)
+			continue;
+		c->waiting = false;
+		ok = server_process (s, c, false);
+		if (ok && c->out.len > c->sent)
+			ok = client_flush (c);
+		if (!ok)
+			client_close (s, i - 1);
+	}
+}
+
+/* Empties the wake-up pipe, collecting the solver if it is done */
+static void
+server_wake (struct server REF(s))
+{
+	char buf[64];
+	cdor_bool done = false;
+	ssize_t n, k;
+	while ((n = read (daemon_wake[0], buf, sizeof buf)) > 0) {
+		for (k = 0; k < n; k++)
+			done = done || buf[k] == 's';
+	}
+#ifdef CDOR_THREADS
+	if (done && s->solving) {
+		pthread_join (s->solver, NULL);
+		server_solved (s);
+		server_resume (s);
+	}
+#else
+	(void) s;
+	(void) done;
+#endif
+}
+
+/* Serves until a signal stops it, or until the last client leaves if there
+ * is no listener */
+static int
+server_run (struct server REF(s), const int listener,
+            const char * const snapshot)
+{
+	struct pollfd *fds = NULL;
+	size_t i;
+	int status = 0;
+	while (!daemon_stop && (listener >= 0 || s->nclients > 0)) {
+		struct pollfd *grown;
+		if (daemon_save) {
+			daemon_save = 0;
+			server_tally (s);
+			if (snapshot && server_save (s, snapshot) != 0)
+				perror (snapshot);
+		}
+		if (!(grown = (struct pollfd *)
+		      realloc (fds, (s->nclients + 2) * sizeof *fds))) {
+			status = -1;
+			break;
+		}
+		fds = grown;
+		/* Negative descriptors are ignored */
+		fds[0].fd = listener;
+		fds[0].events = POLLIN;
+		fds[1].fd = daemon_wake[0];
+		fds[1].events = POLLIN;
+		for (i = 0; i < s->nclients; i++) {
+			const struct client * const c = &s->client[i];
+			const cdor_bool unsent = c->out.len > c->sent;
+			fds[i + 2].fd = c->fd;
+			/* Waiting clients are not read until answered */
+			fds[i + 2].events = c->waiting
+			                    || c->out.len - c->sent >= DAEMON_BACKLOG
+			                    ? (unsent ? POLLOUT : 0)
+			                    : unsent ? POLLIN | POLLOUT : POLLIN;
+		}
+		if (poll (fds, s->nclients + 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			status = -1;
+			break;
+		}
+		/* Backwards, since closing moves the last client */
+		for (i = s->nclients; i > 0; i--) {
+			struct client * const c = &s->client[i - 1];
+			const short ev = fds[i + 1].revents;
+			cdor_bool ok = true;
+			if (ev & (POLLERR | POLLNVAL))
+				ok = false;
+			else if (ev & (POLLIN | POLLHUP))
+				ok = client_read (s, c);
+			if (ok && c->out.len > c->sent)
+				ok = client_flush (c);
+			if (!ok)
+				client_close (s, i - 1);
+		}
+		if (fds[1].revents & POLLIN)
+			server_wake (s);
+		if (fds[0].revents & POLLIN)
+			server_accept (s, listener);
+	}
+	free (fds);
+	return status;
+}
+
+/* Loads the snapshot if there is one, otherwise starts from scratch */
+static int
+server_init (struct server REF(s), size_t nalt, const char * const snapshot)
+{
+	FILE *f;
+	memset (s, 0, sizeof *s);
+	if (snapshot && (f = fopen (snapshot, "rb"))) {
+		size_t n;
+		s->duels = cdor_load_duels (f, &n);
+		fclose (f);
+		if (!s->duels)
+			return -1;
+		if (nalt != 0 && nalt != n) {
+			errno = EINVAL;
+			return -1;
+		}
+		nalt = n;
+	} else if (snapshot && errno != ENOENT) {
+		return -1;
+	}
+	/* The advantage graph must fit in a reply */
+	if (nalt == 0 || nalt > ((size_t) UINT32_MAX - 8) / 8 / nalt) {
+		errno = EINVAL;
+		return -1;
+	}
+	s->nalt = nalt;
+	if (!s->duels && !(s->duels = zero_allocate(cdor_adv, nalt * nalt)))
+		return -1;
+	if (!(s->pending = cdor_ballot_set_new (nalt))
+	    || !(s->rank = allocate(size_t, nalt))
+	    || !(s->graph = allocate(char, nalt * nalt))
+	    || !(s->next = allocate(char, nalt * nalt)))
+		return -1;
+	/* Refuses elections too big to solve now rather than at every query */
+	memset (s->graph, 0, nalt * nalt);
+	switch (cdor_compute_strategy (nalt, s->graph, &s->strat)) {
+	case CDOR_OK:
+		if (s->strat.type == CDOR_SPARSE)
+			free (s->strat.val.sparse.supp);
+		break;
+	case CDOR_NOMEM:
+		errno = ENOMEM;
+		return -1;
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+	s->changed = true;
+	return 0;
+}
+
+static void
+server_free (struct server REF(s))
+{
+#ifdef CDOR_THREADS
+	if (s->solving) {
+		pthread_join (s->solver, NULL);
+		server_solved (s);
+	}
+#endif
+	while (s->nclients > 0)
+		client_close (s, s->nclients - 1);
+	free (s->client);
+	if (s->solved && s->strat.type == CDOR_SPARSE)
+		free (s->strat.val.sparse.supp);
+	free (s->next);
+	free (s->graph);
+	free (s->rank);
+	cdor_ballot_set_free (s->pending);
+	free (s->duels);
+}
+
+int
+main (int argc, char **argv)
+{
+	const char *snapshot = NULL;
+	struct sigaction sa;
+	struct server s;
+	size_t nalt = 0;
+	cdor_bool inetd = false;
+	int opt, listener = -1, status = EXIT_FAILURE;
+	while ((opt = getopt (argc, argv, "in:s:")) != -1) {
+		switch (opt) {
+		case 'i':
+			inetd = true;
+			break;
+		case 'n':
+			nalt = (size_t) strtoul (optarg, NULL, 10);
+			break;
+		case 's':
+			snapshot = optarg;
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc - !inetd || (nalt == 0 && !snapshot))
+		goto usage;
+	if (server_init (&s, nalt, snapshot) != 0) {
+		perror (snapshot ? snapshot : argv[0]);
+		server_free (&s);
+		return EXIT_FAILURE;
+	}
+	if (pipe (daemon_wake) != 0
+	    || fcntl (daemon_wake[0], F_SETFL, O_NONBLOCK) != 0
+	    || fcntl (daemon_wake[1], F_SETFL, O_NONBLOCK) != 0) {
+		perror (argv[0]);
+		server_free (&s);
+		return EXIT_FAILURE;
+	}
+	/* Like under inetd, the only client is the standard input */
+	if (inetd ? !server_add (&s, STDIN_FILENO)
+	    : (listener = server_listen (argv[optind])) < 0) {
+		perror (inetd ? argv[0] : argv[optind]);
+		server_free (&s);
+		return EXIT_FAILURE;
+	}
+	memset (&sa, 0, sizeof sa);
+	sigemptyset (&sa.sa_mask);
+	/* No SA_RESTART, so that poll notices the signals */
+	sa.sa_handler = daemon_signal;
+	sigaction (SIGINT, &sa, NULL);
+	sigaction (SIGTERM, &sa, NULL);
+	sigaction (SIGHUP, &sa, NULL);
+	sa.sa_handler = SIG_IGN;
+	sigaction (SIGPIPE, &sa, NULL);
+	if (server_run (&s, listener, snapshot) != 0) {
+		perror (argv[0]);
+	} else {
+		server_tally (&s);
+		if (snapshot && server_save (&s, snapshot) != 0)
+			perror (snapshot);
+		else
+			status = EXIT_SUCCESS;
+	}
+	if (!inetd) {
+		close (listener);
+		unlink (argv[optind]);
+	}
+	server_free (&s);
+	return status;
+usage:
+	fprintf (stderr, "usage: %s [-n alternatives] [-s snapshot] socket\n"
+	         "       %s -i [-n alternatives] [-s snapshot]\n",
+	         argv[0], argv[0]);
+	return EXIT_FAILURE;
+}
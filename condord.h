@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CONDORD_H_INCLUDED
+#define CONDORD_H_INCLUDED
+
+/*
+ * Protocol of the condord results daemon.  Every integer is unsigned and in
+ * native byte order since the socket is local.  A request is a 32-bit size,
+ * counting the bytes after it, followed by a 32-bit operation and its
+ * payload.  A reply is a 32-bit size followed by a 32-bit status and, on
+ * success, the result of the operation.  Replies to ballots always have it.
+ */
+
+/* Largest size of a request, bigger ones close the connection */
+#define CDORD_MAX_REQUEST ((unsigned long) 1 << 24)
+
+enum cdord_op {
+	/* Payload: ballots, each a 32-bit weight then one 32-bit rank per
+	 * alternative as in cdor_cast_ranking; result, even on failure: the
+	 * 32-bit number of ballots counted, the first ones of the payload */
+	CDORD_BALLOTS = 1,
+	/* Payload: nothing; result: a 32-bit length then as many pairs of a
+	 * 32-bit alternative and a double probability */
+	CDORD_STRATEGY = 2,
+	/* Payload: nothing; result: a 32-bit number of alternatives n then the
+	 * n * n counters of the advantage graph, 64 bits each */
+	CDORD_DUELS = 3
+};
+
+enum cdord_status {
+	CDORD_OK,
+	CDORD_INVALID,
+	CDORD_NOMEM,
+	CDORD_UNSOLVED,
+	CDORD_RANGE
+};
+
+#endif /* CONDORD_H_INCLUDED */
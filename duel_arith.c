@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <errno.h>
+#include <stddef.h>
+
+#include "condor.h"
+#include "util.h"
+
+/*
+ * The loops below accumulate overflow flags without branching so that they
+ * vectorize.  Since unsigned arithmetic is modular, a failed addition or
+ * subtraction is undone exactly by the opposite operation.
+ */
+
+int
+cdor_add_duels (const size_t nalt, cdor_adv * CDOR_RESTRICT const dest,
+                const cdor_adv * CDOR_RESTRICT const src)
+{
+	const size_t n = nalt * nalt;
+	cdor_adv ovf = 0;
+	size_t i;
+	for (i = 0; i < n; i++) {
+		const cdor_adv s = dest[i] + src[i];
+		ovf |= (cdor_adv) (s < src[i]);
+		dest[i] = s;
+	}
+	if (!ovf)
+		return 0;
+	for (i = 0; i < n; i++)
+		dest[i] -= src[i];
+	set_errno (ERANGE);
+	return -1;
+}
+
+int
+cdor_subtract_duels (const size_t nalt, cdor_adv * CDOR_RESTRICT const dest,
+                     const cdor_adv * CDOR_RESTRICT const src)
+{
+	const size_t n = nalt * nalt;
+	cdor_adv ovf = 0;
+	size_t i;
+	for (i = 0; i < n; i++) {
+		ovf |= (cdor_adv) (dest[i] < src[i]);
+		dest[i] -= src[i];
+	}
+	if (!ovf)
+		return 0;
+	for (i = 0; i < n; i++)
+		dest[i] += src[i];
+	set_errno (ERANGE);
+	return -1;
+}
+
+int
+cdor_scale_duels (const size_t nalt, cdor_adv * CDOR_RESTRICT const dest,
+                  const cdor_adv factor)
+{
+	const size_t n = nalt * nalt;
+	const cdor_adv limit = factor ? (cdor_adv) -1 / factor : (cdor_adv) -1;
+	cdor_adv ovf = 0;
+	size_t i;
+	/* Multiplication cannot be undone, so check first */
+	for (i = 0; i < n; i++)
+		ovf |= (cdor_adv) (dest[i] > limit);
+	if (ovf) {
+		set_errno (ERANGE);
+		return -1;
+	}
+	for (i = 0; i < n; i++)
+		dest[i] *= factor;
+	return 0;
+}
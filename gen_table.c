@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Build-time generator of strategy_table.h: solves every duel graph among up
+ * to the given number of alternatives and prints the distinct strategies
+ * together with, for each size, the strategy of each packed graph.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "condor.h"
+#include "util.h"
+
+/* Among 6 alternatives, the 3^15 graphs would take tens of megabytes */
+#define GEN_MAX 5
+
+struct gen_strat {
+	size_t start;
+	size_t len;
+};
+
+struct gen {
+	struct cdor_prob *supp;
+	size_t supp_len;
+	size_t supp_cap;
+	struct gen_strat *strat;
+	size_t nstrat;
+	size_t strat_cap;
+	/* Open-addressing index of strat, at least twice its capacity */
+	size_t *slot;
+	size_t mask;
+};
+
+/* The generator solves everything itself */
+const size_t cdor_table_max = 0;
+
+cdor_bool
+cdor_table_strategy (const size_t nalt, const char * CDOR_RESTRICT graph,
+                     struct cdor_strategy * CDOR_RESTRICT r)
+{
+	(void) nalt;
+	(void) graph;
+	(void) r;
+	return false;
+}
+
+static size_t
+gen_hash (const size_t len, const struct cdor_prob * CDOR_RESTRICT supp)
+{
+	size_t h = 2166136261UL, i;
+	for (i = 0; i < len; i++) {
+		unsigned char bytes[sizeof (double)];
+		size_t k;
+		memcpy (bytes, &supp[i].prob, sizeof (double));
+		h = (h ^ supp[i].alt) * 16777619UL;
+		for (k = 0; k < sizeof (double); k++)
+			h = (h ^ bytes[k]) * 16777619UL;
+	}
+	return h ^ h >> 15;
+}
+
+static cdor_bool
+gen_same (const struct gen REF(g), const size_t k, const size_t len,
+          const struct cdor_prob * CDOR_RESTRICT supp)
+{
+	size_t i;
+	if (g->strat[k].len != len)
+		return false;
+	for (i = 0; i < len; i++) {
+		const struct cdor_prob p = g->supp[g->strat[k].start + i];
+		if (p.alt != supp[i].alt
+		    || memcmp (&p.prob, &supp[i].prob, sizeof (double)) != 0)
+			return false;
+	}
+	return true;
+}
+
+/* Returns the number of the strategy, adding it if it is new */
+static size_t
+gen_intern (struct gen REF(g), const size_t len,
+            const struct cdor_prob * CDOR_RESTRICT supp)
+{
+	const size_t mask = g->mask;
+	size_t i = gen_hash (len, supp) & mask;
+	while (g->slot[i] != (size_t) -1) {
+		if (gen_same (g, g->slot[i], len, supp))
+			return g->slot[i];
+		i = (i + 1) & mask;
+	}
+	if (g->nstrat == g->strat_cap || g->supp_len + len > g->supp_cap)
+		return (size_t) -1;
+	memcpy (g->supp + g->supp_len, supp, len * sizeof *supp);
+	g->strat[g->nstrat].start = g->supp_len;
+	g->strat[g->nstrat].len = len;
+	g->supp_len += len;
+	g->slot[i] = g->nstrat;
+	return g->nstrat++;
+}
+
+static size_t
+gen_pairs (const size_t nalt)
+{
+	return nalt * (nalt - 1) / 2;
+}
+
+static size_t
+gen_count (const size_t nalt)
+{
+	size_t count = 1, k;
+	for (k = 0; k < gen_pairs (nalt); k++)
+		count *= 3;
+	return count;
+}
+
+/* Unpacks graph number index, one base 3 digit per pair as in the lookup */
+static void
+gen_unpack (const size_t nalt, char * CDOR_RESTRICT graph, size_t index)
+{
+	size_t i, j;
+	memset (graph, 0, nalt * nalt);
+	for (i = 0; i < nalt; i++) {
+		for (j = i + 1; j < nalt; j++, index /= 3) {
+			graph[i * nalt + j] = index % 3 == 1;
+			graph[j * nalt + i] = index % 3 == 2;
+		}
+	}
+}
+
+static cdor_bool
+gen_solve (struct gen REF(g), const size_t nalt, size_t * CDOR_RESTRICT index)
+{
+	const size_t count = gen_count (nalt);
+	char graph[GEN_MAX * GEN_MAX];
+	size_t k;
+	for (k = 0; k < count; k++) {
+		struct cdor_strategy r;
+		struct cdor_prob pure;
+		gen_unpack (nalt, graph, k);
+		r = cdor_sparse_strategy (nalt, graph);
+		if (r.type == CDOR_PURE) {
+			pure.alt = r.val.pure;
+			pure.prob = 1.0;
+			index[k] = gen_intern (g, 1, &pure);
+		} else if (r.type == CDOR_SPARSE && r.val.sparse.len > 1) {
+			index[k] = gen_intern (g, r.val.sparse.len,
+			                       r.val.sparse.supp);
+			free (r.val.sparse.supp);
+		} else {
+			/* A support of one alternative would read as pure */
+			if (r.type == CDOR_SPARSE)
+				free (r.val.sparse.supp);
+			return false;
+		}
+		if (index[k] == (size_t) -1)
+			return false;
+	}
+	return true;
+}
+
+static void
+gen_print (const struct gen REF(g), const size_t max,
+           size_t * const index[])
+{
+	size_t nalt, k;
+	printf ("/* Generated by gen_table, do not edit */\n"
+	        "#define TABLE_MAX %lu\n\n", (unsigned long) max);
+	if (max < 2)
+		return;
+	printf ("typedef %s table_index;\n\n",
+	        g->nstrat <= 65536 ? "unsigned short" : "unsigned long");
+	puts ("static const struct cdor_prob table_supp[] = {");
+	for (k = 0; k < g->supp_len; k++)
+		printf ("\t{ %lu, %.17g },\n", (unsigned long) g->supp[k].alt,
+		        g->supp[k].prob);
+	puts ("};\n\nstatic const unsigned long table_start[] = {");
+	for (k = 0; k < g->nstrat; k++)
+		printf ("\t%lu,\n", (unsigned long) g->strat[k].start);
+	printf ("\t%lu\n};\n", (unsigned long) g->supp_len);
+	for (nalt = 2; nalt <= max; nalt++) {
+		printf ("\nstatic const table_index table_%lu[] = {",
+		        (unsigned long) nalt);
+		for (k = 0; k < gen_count (nalt); k++)
+			printf ("%s%lu", !k ? "\n\t" : k % 12 ? ", " : ",\n\t",
+			        (unsigned long) index[nalt][k]);
+		puts ("\n};");
+	}
+	puts ("\nstatic const table_index * const table_by_size[] = {");
+	fputs ("\tNULL,\n\tNULL", stdout);
+	for (nalt = 2; nalt <= max; nalt++)
+		printf (",\n\ttable_%lu", (unsigned long) nalt);
+	puts ("\n};");
+}
+
+int
+main (int argc, char **argv)
+{
+	size_t *index[GEN_MAX + 1] = { NULL };
+	struct gen g;
+	size_t max, total = 0, nalt, k;
+	int status = EXIT_FAILURE;
+	if (argc != 2
+	    || (max = (size_t) strtoul (argv[1], NULL, 10)) > GEN_MAX) {
+		fprintf (stderr, "usage: %s N, with N at most %d\n", argv[0],
+		         GEN_MAX);
+		return EXIT_FAILURE;
+	}
+	for (nalt = 2; nalt <= max; nalt++)
+		total += gen_count (nalt);
+	/* Each graph brings at most one new strategy of at most max entries */
+	g.strat_cap = total > 0 ? total : 1;
+	g.supp_cap = g.strat_cap * (max > 0 ? max : 1);
+	g.supp = allocate(struct cdor_prob, g.supp_cap);
+	g.strat = allocate(struct gen_strat, g.strat_cap);
+	for (g.mask = 1; g.mask < 2 * g.strat_cap; g.mask *= 2)
+		continue;
+	g.slot = allocate(size_t, g.mask--);
+	g.supp_len = g.nstrat = 0;
+	if (!g.supp || !g.strat || !g.slot) {
+		perror (argv[0]);
+		goto end;
+	}
+	for (k = 0; k <= g.mask; k++)
+		g.slot[k] = (size_t) -1;
+	for (nalt = 2; nalt <= max; nalt++) {
+		if (!(index[nalt] = allocate(size_t, gen_count (nalt)))) {
+			perror (argv[0]);
+			goto end;
+		}
+		if (!gen_solve (&g, nalt, index[nalt])) {
+			fprintf (stderr, "%s: could not solve graphs among %lu "
+			         "alternatives\n", argv[0], (unsigned long) nalt);
+			goto end;
+		}
+	}
+	gen_print (&g, max, index);
+	status = fflush (stdout) == 0 && !ferror (stdout) ? EXIT_SUCCESS
+	                                                  : EXIT_FAILURE;
+end:
+	for (nalt = 0; nalt <= GEN_MAX; nalt++)
+		free (index[nalt]);
+	free (g.slot);
+	free (g.strat);
+	free (g.supp);
+	return status;
+}
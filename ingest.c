@@ -0,0 +1,347 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "condor.h"
+#include "util.h"
+
+#ifdef CDOR_THREADS
+#include <pthread.h>
+#endif
+
+/* Bytes per read, ballots per batch and bytes of distinct ballots kept */
+#define INGEST_CHUNK ((size_t) 1 << 20)
+#define INGEST_BATCH 128
+#define INGEST_DEDUP ((size_t) 1 << 22)
+
+#define UNRANKED ((size_t) -1)
+
+struct ballot_batch {
+	size_t len;
+	size_t *rank;
+	cdor_bool ready;
+};
+
+enum parse_state { P_START, P_NUMBER, P_AFTER_NUMBER, P_AFTER_OP, P_COMMENT };
+
+struct ingest {
+	size_t nalt;
+	cdor_adv *duels;
+	size_t count;
+	/* Identical ballots are tallied once, owned by the tally stage */
+	struct cdor_ballot_set *dedup;
+	size_t dedup_max;
+	/* Parser state, ballots are parsed straight into the batch */
+	enum parse_state state;
+	size_t level;
+	size_t num;
+	size_t ranked;
+	/* Double buffer: one batch is parsed while the other is tallied */
+	struct ballot_batch batch[2];
+	unsigned cur;
+#ifdef CDOR_THREADS
+	cdor_bool threaded;
+	cdor_bool done;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t consumer;
+#endif
+};
+
+static void
+ingest_tally (struct ingest REF(in), const struct ballot_batch REF(b))
+{
+	size_t i;
+	for (i = 0; i < b->len; i++) {
+		const size_t * const rank = b->rank + i * in->nalt;
+		if (!in->dedup || cdor_ballot_set_add (in->dedup, rank, 1) < 0)
+			cdor_cast_ranking (in->nalt, in->duels, rank);
+		else if (cdor_ballot_set_size (in->dedup) >= in->dedup_max)
+			cdor_ballot_set_flush (in->dedup, in->duels);
+	}
+}
+
+#ifdef CDOR_THREADS
+static void *
+ingest_consumer (void *arg)
+{
+	struct ingest * const in = (struct ingest *) arg;
+	unsigned cur = 0;
+	for (;;) {
+		struct ballot_batch * const b = &in->batch[cur];
+		cdor_bool ready;
+		pthread_mutex_lock (&in->lock);
+		while (!b->ready && !in->done)
+			pthread_cond_wait (&in->cond, &in->lock);
+		ready = b->ready;
+		pthread_mutex_unlock (&in->lock);
+		if (!ready)
+			return NULL;
+		ingest_tally (in, b);
+		pthread_mutex_lock (&in->lock);
+		b->ready = false;
+		pthread_cond_broadcast (&in->cond);
+		pthread_mutex_unlock (&in->lock);
+		cur ^= 1u;
+	}
+}
+#endif
+
+/* Hands the current batch over to the tally stage */
+static void
+ingest_submit (struct ingest REF(in))
+{
+	struct ballot_batch * const b = &in->batch[in->cur];
+	in->count += b->len;
+#ifdef CDOR_THREADS
+	if (in->threaded) {
+		struct ballot_batch * const next = &in->batch[in->cur ^ 1u];
+		pthread_mutex_lock (&in->lock);
+		b->ready = true;
+		pthread_cond_broadcast (&in->cond);
+		while (next->ready)
+			pthread_cond_wait (&in->cond, &in->lock);
+		pthread_mutex_unlock (&in->lock);
+		in->cur ^= 1u;
+		next->len = 0;
+		return;
+	}
+#endif
+	ingest_tally (in, b);
+	b->len = 0;
+}
+
+static size_t *
+ingest_row (struct ingest REF(in))
+{
+	struct ballot_batch * const b = &in->batch[in->cur];
+	return b->rank + b->len * in->nalt;
+}
+
+static void
+ingest_begin_ballot (struct ingest REF(in))
+{
+	size_t * const row = ingest_row (in);
+	size_t i;
+	for (i = 0; i < in->nalt; i++)
+		row[i] = UNRANKED;
+	in->level = 0;
+	in->ranked = 0;
+}
+
+static cdor_bool
+ingest_number (struct ingest REF(in))
+{
+	size_t * const row = ingest_row (in);
+	if (row[in->num] != UNRANKED)
+		return false;
+	row[in->num] = in->level;
+	in->ranked++;
+	return true;
+}
+
+static void
+ingest_end_ballot (struct ingest REF(in))
+{
+	if (in->ranked > 0 && ++in->batch[in->cur].len == INGEST_BATCH)
+		ingest_submit (in);
+	in->ranked = 0;
+	in->state = P_START;
+}
+
+static cdor_bool
+ingest_parse (struct ingest REF(in), const size_t len,
+              const char * CDOR_RESTRICT const buf)
+{
+	size_t i;
+	for (i = 0; i < len; i++) {
+		const char c = buf[i];
+		if (in->state == P_COMMENT) {
+			if (c == '\n')
+				ingest_end_ballot (in);
+			continue;
+		}
+		if (c >= '0' && c <= '9') {
+			const size_t d = (size_t) (c - '0');
+			switch (in->state) {
+			case P_START:
+				ingest_begin_ballot (in);
+				/* fallthrough */
+			case P_AFTER_OP:
+				in->num = d;
+				in->state = P_NUMBER;
+				break;
+			case P_NUMBER:
+				/* Cannot overflow since num < nalt */
+				in->num = in->num * 10 + d;
+				break;
+			default:
+				return false;
+			}
+			if (in->num >= in->nalt)
+				return false;
+			continue;
+		}
+		if (in->state == P_NUMBER) {
+			if (!ingest_number (in))
+				return false;
+			in->state = P_AFTER_NUMBER;
+		}
+		switch (c) {
+		case ' ':
+		case '\t':
+		case '\r':
+			break;
+		case '>':
+			in->level++;
+			/* fallthrough */
+		case '=':
+			if (in->state != P_AFTER_NUMBER)
+				return false;
+			in->state = P_AFTER_OP;
+			break;
+		case '#':
+			if (in->state == P_AFTER_OP)
+				return false;
+			in->state = P_COMMENT;
+			break;
+		case '\n':
+			if (in->state == P_AFTER_OP)
+				return false;
+			ingest_end_ballot (in);
+			break;
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
+static cdor_bool
+ingest_init (struct ingest REF(in), const size_t nalt,
+             cdor_adv * CDOR_RESTRICT const duels)
+{
+	unsigned k;
+	in->nalt = nalt;
+	in->duels = duels;
+	in->count = 0;
+	in->state = P_START;
+	in->level = 0;
+	in->ranked = 0;
+	in->cur = 0;
+	/* Deduplication is only an optimization, so failing is harmless */
+	in->dedup = cdor_ballot_set_new (nalt);
+	in->dedup_max = INGEST_DEDUP / sizeof (size_t) / nalt + 1;
+	for (k = 0; k < 2; k++) {
+		in->batch[k].len = 0;
+		in->batch[k].ready = false;
+		if (!(in->batch[k].rank = allocate(size_t, INGEST_BATCH * nalt))) {
+			if (k > 0)
+				free (in->batch[0].rank);
+			cdor_ballot_set_free (in->dedup);
+			return false;
+		}
+	}
+#ifdef CDOR_THREADS
+	in->done = false;
+	in->threaded = false;
+	if (pthread_mutex_init (&in->lock, NULL) == 0) {
+		if (pthread_cond_init (&in->cond, NULL) != 0)
+			pthread_mutex_destroy (&in->lock);
+		else if (pthread_create (&in->consumer, NULL, ingest_consumer,
+		                         in) != 0) {
+			pthread_cond_destroy (&in->cond);
+			pthread_mutex_destroy (&in->lock);
+		} else {
+			in->threaded = true;
+		}
+	}
+	/* Without a consumer thread, batches are tallied in place */
+#endif
+	return true;
+}
+
+static void
+ingest_finish (struct ingest REF(in))
+{
+	if (in->batch[in->cur].len > 0)
+		ingest_submit (in);
+#ifdef CDOR_THREADS
+	if (in->threaded) {
+		pthread_mutex_lock (&in->lock);
+		in->done = true;
+		pthread_cond_broadcast (&in->cond);
+		pthread_mutex_unlock (&in->lock);
+		pthread_join (in->consumer, NULL);
+		pthread_cond_destroy (&in->cond);
+		pthread_mutex_destroy (&in->lock);
+	}
+#endif
+	if (in->dedup) {
+		cdor_ballot_set_flush (in->dedup, in->duels);
+		cdor_ballot_set_free (in->dedup);
+	}
+	free (in->batch[0].rank);
+	free (in->batch[1].rank);
+}
+
+int
+cdor_ingest_ballots (FILE * CDOR_RESTRICT const f, const size_t nalt,
+                     cdor_adv * CDOR_RESTRICT const duels,
+                     size_t * CDOR_RESTRICT const count)
+{
+	struct ingest in;
+	char *buf;
+	cdor_bool ok = true;
+	if (nalt == 0 || nalt > (size_t) -1 / INGEST_BATCH) {
+		set_errno (EINVAL);
+		return -1;
+	}
+	if (!(buf = allocate(char, INGEST_CHUNK)))
+		return -1;
+	if (!ingest_init (&in, nalt, duels)) {
+		free (buf);
+		return -1;
+	}
+	for (;;) {
+		const size_t len = fread (buf, 1, INGEST_CHUNK, f);
+		if (!ingest_parse (&in, len, buf)) {
+			set_errno (EINVAL);
+			ok = false;
+			break;
+		}
+		if (len < INGEST_CHUNK) {
+			/* The last line needs no terminating newline */
+			if (ferror (f)) {
+				ok = false;
+			} else if (!ingest_parse (&in, 1, "\n")) {
+				set_errno (EINVAL);
+				ok = false;
+			}
+			break;
+		}
+	}
+	/* Ballots parsed before an error are still tallied */
+	ingest_finish (&in);
+	free (buf);
+	if (count)
+		*count = in.count;
+	return ok ? 0 : -1;
+}
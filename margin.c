@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stddef.h>
+
+#include "condor.h"
+#include "util.h"
+
+/*
+ * The strict upper triangle is stored row by row, so the margin of i over j
+ * for i < j lives at i * n - i * (i + 1) / 2 + j - i - 1 and each row is
+ * contiguous.
+ */
+
+size_t
+cdor_margin_size (const size_t nalt)
+{
+	return nalt > 0 ? nalt * (nalt - 1) / 2 : 0;
+}
+
+void
+cdor_cast_margin_ballot (const size_t nalt,
+                         cdor_margin * CDOR_RESTRICT margins,
+                         int (*ballot) (size_t, size_t))
+{
+	size_t i, j;
+	for (i = 0; i < nalt; i++) {
+		for (j = i + 1; j < nalt; j++, margins++) {
+			const int cmp = ballot (i, j);
+			*margins += (cmp > 0) - (cmp < 0);
+		}
+	}
+}
+
+void
+cdor_cast_margin_ranking (const size_t nalt,
+                          cdor_margin * CDOR_RESTRICT margins,
+                          const size_t * CDOR_RESTRICT rank,
+                          const cdor_margin weight)
+{
+	size_t i, j;
+	for (i = 0; i < nalt; i++) {
+		const size_t ri = rank[i];
+		for (j = i + 1; j < nalt; j++) {
+			const cdor_margin d = (cdor_margin) (ri < rank[j])
+			                      - (cdor_margin) (rank[j] < ri);
+			margins[j - i - 1] += d * weight;
+		}
+		margins += nalt - i - 1;
+	}
+}
+
+void
+cdor_make_margin_graph (const size_t nalt, char * CDOR_RESTRICT graph,
+                        const cdor_margin * CDOR_RESTRICT margins)
+{
+	size_t i, j;
+	for (i = 0; i < nalt; i++) {
+		graph[i * nalt + i] = 0;
+		for (j = i + 1; j < nalt; j++, margins++) {
+			graph[i * nalt + j] = *margins > 0;
+			graph[j * nalt + i] = *margins < 0;
+		}
+	}
+}
@@ -17,7 +17,6 @@
 #include <assert.h>
 #include <errno.h>
 #include <limits.h>
-#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -48,21 +47,17 @@ prep_row_coord (const cdor_bool direct, const cdor_bool indirect,
 
 static lprec *
 cdor_prepare (const size_t nalt, const cdor_bool ARR_PARAM(graph, nalt * nalt),
-              const cdor_bool minimax)
+              const cdor_bool minimax, enum cdor_status REF(status))
 {
 	lprec * CDOR_RESTRICT prob = NULL;
 	double * CDOR_RESTRICT row;
 	unsigned int r;
 	if (nalt >= INT_MAX) {
-#if _POSIX_C_SOURCE >= 1L
-		errno = EINVAL;
-#endif
+		*status = CDOR_INVALID;
 		return NULL;
 	}
 	if (!(prob = make_lp (0, (int) nalt))) {
-#if _POSIX_C_SOURCE >= 1L
-		errno = ENOMEM;
-#endif
+		*status = CDOR_NOMEM;
 		return NULL;
 	}
 	set_verbose (prob, NEUTRAL);
@@ -70,6 +65,7 @@ cdor_prepare (const size_t nalt, const cdor_bool ARR_PARAM(graph, nalt * nalt),
 		set_maxim (prob);
 	if (!(row = allocate(double, nalt + 1))) {
 		delete_lp (prob);
+		*status = CDOR_NOMEM;
 		return NULL;
 	}
 	for (r = 1; r <= nalt; r++) {
@@ -84,9 +80,7 @@ cdor_prepare (const size_t nalt, const cdor_bool ARR_PARAM(graph, nalt * nalt),
 		if (!add_constraint (prob, row, minimax ? LE : GE, 1.0)) {
 			free (row);
 			delete_lp (prob);
-#if _POSIX_C_SOURCE >= 1L
-			errno = ENOMEM;
-#endif
+			*status = CDOR_NOMEM;
 			return NULL;
 		}
 	}
@@ -95,61 +89,12 @@ cdor_prepare (const size_t nalt, const cdor_bool ARR_PARAM(graph, nalt * nalt),
 }
 
 #ifdef __GNUC__
-__attribute__ ((const, nonnull (1, 2)))
-#endif
-static int
-comp_double (const void * CDOR_RESTRICT const x_arg,
-             const void * CDOR_RESTRICT const y_arg)
-{
-	double x = *(double *) x_arg, y = *(double *) y_arg;
-	return (x > y) - (x < y);
-}
-
-static double
-cdor_sum (const size_t n, const double ARR_PARAM(x, n))
-{
-	double * const a = allocate(double, n);
-	double s = 0.0;
-	if (a != NULL) {
-		size_t i;
-		memcpy (a, x, n * sizeof (double));
-		qsort (a, n, sizeof (double), comp_double);
-		for (i = 0; i < n; i++)
-			s += a[i];
-		free (a);
-		return s;
-	} else {
-		/* Slower but doesn't need memory */
-		double min = 0.0;
-		int found = 0;
-		for (;;) {
-			double new_min = HUGE_VAL;
-			size_t i, im = 0;
-			for (i = 0; i < n; i++) {
-				if (x[i] > min && x[i] < new_min) {
-					new_min = x[i];
-					im = i;
-					found = 1;
-				}
-			}
-			if (!found)
-				return s;
-			for (i = im; i < n; i++) {
-				if (x[i] == new_min)
-					s += new_min;
-			}
-			min = new_min;
-			found = 0;
-		}
-	}
-}
- 
-#ifdef __GNUC__
-__attribute__((nonnull (1)))
+__attribute__((nonnull (1, 4)))
 #endif
 static cdor_bool
 cdor_solve_finalize (lprec REF(prob), const size_t nalt,
-                     double ARR_PARAM(dest, nalt))
+                     double ARR_PARAM(dest, nalt),
+                     enum cdor_status REF(status))
 {
 	double norm;
 	size_t c;
@@ -165,23 +110,21 @@ cdor_solve_finalize (lprec REF(prob), const size_t nalt,
 	return true;
 fail:
 	delete_lp (prob);
-#if _POSIX_C_SOURCE >= 1L
-	errno = EDOM;
-#endif
+	*status = CDOR_UNSOLVED;
 	return false;
 }
 
 static cdor_bool
 cdor_solve (const size_t nalt, double ARR_PARAM(dest, nalt),
             const cdor_bool ARR_PARAM(graph, nalt * nalt),
-            const cdor_bool minimax)
+            const cdor_bool minimax, enum cdor_status REF(status))
 {
 	lprec * CDOR_RESTRICT prob;
 	if (nalt == 0)
 		return true;
-	if (!(prob = cdor_prepare (nalt, graph, minimax)))
+	if (!(prob = cdor_prepare (nalt, graph, minimax, status)))
 		return false;
-	return cdor_solve_finalize (prob, nalt, dest);
+	return cdor_solve_finalize (prob, nalt, dest, status);
 }
 
 static size_t
@@ -305,80 +248,376 @@ cdor_comp_strats (const size_t nalt, const double ARR_PARAM(left, nalt),
 }
 
 #ifdef __GNUC__
-__attribute__((nonnull (2, 3)))
+__attribute__((nonnull (2, 3, 4)))
 #endif
 static cdor_bool
-cdor_optimal (const size_t nalt, double ARR_PARAM(dest, nalt),
-              const cdor_bool ARR_PARAM(graph, nalt * nalt))
+cdor_optimal_lp (const size_t nalt, double ARR_PARAM(dest, nalt),
+                 const cdor_bool ARR_PARAM(graph, nalt * nalt),
+                 enum cdor_status REF(status))
 {
 	assert(nalt >= 2);
-	if (cdor_solve (nalt, dest, graph, true)) {
+	if (cdor_solve (nalt, dest, graph, true, status)) {
 		double * const right = allocate(double, nalt);
-		if (right && cdor_solve (nalt, right, graph, false)) {
+		if (right && cdor_solve (nalt, right, graph, false, status)) {
 			if (!cdor_comp_strats (nalt, dest, graph, right))
 				memcpy (dest, right, nalt * sizeof (double));
 		}
 		free (right);
+		/* dest is optimal already, the second one could only beat it */
+		*status = CDOR_OK;
 		return true;
 	} else {
-		return cdor_solve (nalt, dest, graph, false);
+		return cdor_solve (nalt, dest, graph, false, status);
 	}
 }
 
+/*
+ * Presolve: whenever the row of an alternative k in cdor_prepare is nowhere
+ * above the row of another alternative l, k is removed, since every optimal
+ * strategy without k is still optimal with it.  If both rows are equal, k is
+ * a clone of l and the probability of l is later shared among its clones.
+ * Alternatives losing to everyone else are the most common case.  Removals
+ * may make new rows comparable, so they are repeated until none applies.
+ */
+
+static int
+presolve_payoff (const size_t nalt,
+                 const cdor_bool ARR_PARAM(graph, nalt * nalt),
+                 const size_t i, const size_t j)
+{
+	return (int) graph[i * nalt + j] - (int) graph[j * nalt + i];
+}
+
+/* Returns -1 unless l dominates k, 0 if they are clones, 1 otherwise */
+static int
+presolve_compare (const size_t nalt,
+                  const cdor_bool ARR_PARAM(graph, nalt * nalt),
+                  const size_t ARR_PARAM(rep, nalt), const size_t k,
+                  const size_t l)
+{
+	int r = 0;
+	size_t j;
+	for (j = 0; j < nalt; j++) {
+		int pk, pl;
+		if (rep[j] != j)
+			continue;
+		pk = presolve_payoff (nalt, graph, k, j);
+		pl = presolve_payoff (nalt, graph, l, j);
+		if (pl < pk)
+			return -1;
+		if (pl > pk)
+			r = 1;
+	}
+	return r;
+}
+
+/*
+ * Sets rep[k] to k for the alternatives left, to the one it is a clone of, or
+ * to (size_t) -1 if k was removed, and returns the number left.
+ */
+static size_t
+presolve (const size_t nalt, const cdor_bool ARR_PARAM(graph, nalt * nalt),
+          size_t ARR_PARAM(rep, nalt))
+{
+	size_t left = nalt, k;
+	cdor_bool changed;
+	for (k = 0; k < nalt; k++)
+		rep[k] = k;
+	do {
+		changed = false;
+		for (k = 0; k < nalt && left > 1; k++) {
+			size_t l;
+			if (rep[k] != k)
+				continue;
+			for (l = 0; l < nalt; l++) {
+				int c;
+				if (l == k || rep[l] != l)
+					continue;
+				if ((c = presolve_compare (nalt, graph, rep, k, l)) < 0)
+					continue;
+				rep[k] = c == 0 ? l : (size_t) -1;
+				left--;
+				changed = true;
+				break;
+			}
+		}
+	} while (changed);
+	return left;
+}
+
+/*
+ * Follows the clones of k, which is removed if the one it copied was: then it
+ * was dominated too.
+ */
+static size_t
+presolve_find (const size_t ARR_PARAM(rep, 1), size_t k)
+{
+	while (k != (size_t) -1 && rep[k] != k)
+		k = rep[k];
+	return k;
+}
+
+#ifdef __GNUC__
+__attribute__((nonnull (2, 3, 4)))
+#endif
 static cdor_bool
-cdor_solve_components (const size_t nalt, double ARR_PARAM(dest, nalt),
-                       const char ARR_PARAM(graph, nalt * nalt))
+cdor_optimal (const size_t nalt, double ARR_PARAM(dest, nalt),
+              const cdor_bool ARR_PARAM(graph, nalt * nalt),
+              enum cdor_status REF(status))
 {
-	struct wcc_data wcc;
-	double *strats, *strat_wcc = NULL, *strat, *term = NULL;
+	size_t *rep, *pos, *count;
+	cdor_bool *sub = NULL;
+	double *strat = NULL;
+	size_t left, i, j;
+	cdor_bool ok = false;
+	assert(nalt >= 2);
+	if (!(rep = allocate(size_t, 3 * nalt))) {
+		*status = CDOR_NOMEM;
+		return false;
+	}
+	pos = rep + nalt;
+	count = pos + nalt;
+	if ((left = presolve (nalt, graph, rep)) == nalt) {
+		free (rep);
+		return cdor_optimal_lp (nalt, dest, graph, status);
+	}
+	if (!(sub = allocate(cdor_bool, left * left))
+	    || !(strat = allocate(double, left))) {
+		*status = CDOR_NOMEM;
+		goto end;
+	}
+	for (i = 0, left = 0; i < nalt; i++) {
+		count[i] = 0;
+		if (rep[i] == i)
+			pos[i] = left++;
+	}
+	for (i = 0; i < nalt; i++) {
+		if (rep[i] != i)
+			continue;
+		for (j = 0; j < nalt; j++) {
+			if (rep[j] == j)
+				sub[pos[i] * left + pos[j]] = graph[i * nalt + j];
+		}
+	}
+	if (left == 1)
+		strat[0] = 1.0;
+	else if (!cdor_optimal_lp (left, strat, sub, status))
+		goto end;
+	for (i = 0; i < nalt; i++) {
+		const size_t r = presolve_find (rep, i);
+		if (r != (size_t) -1)
+			count[r]++;
+	}
+	for (i = 0; i < nalt; i++) {
+		const size_t r = presolve_find (rep, i);
+		dest[i] = r == (size_t) -1 ? 0.0
+		          : strat[pos[r]] / (double) count[r];
+	}
+	ok = true;
+end:
+	free (strat);
+	free (sub);
+	free (rep);
+	return ok;
+}
+
+/* Copies the duel graph of a component, whatever the graph is made of */
+typedef void (*wcc_extractor) (size_t, const void *, const struct wcc_data *,
+                               size_t, cdor_bool *);
+
+static void
+graph_extract (const size_t nalt, const void * const graph,
+               const struct wcc_data * const wcc, const size_t cur_wcc,
+               cdor_bool * const g_wcc)
+{
+	cdor_extract_wcc (nalt, (const char *) graph, *wcc, cur_wcc, g_wcc);
+}
+
+/* Solves each component of wcc, which it frees */
+#ifdef __GNUC__
+__attribute__((nonnull (2, 3, 4, 5, 6, 7)))
+#endif
+static cdor_bool
+cdor_solve_wcc (const size_t nalt, size_t REF(len),
+                struct cdor_prob ARR_PARAM(dest, nalt),
+                struct wcc_data REF(wcc), const wcc_extractor extract,
+                const void * CDOR_RESTRICT const data,
+                enum cdor_status REF(status))
+{
+	double *strats, *strat;
+	size_t *pos = NULL;
 	cdor_bool *graph_wcc = NULL;
 	size_t i, j;
 	assert(nalt >= 2);
-	if (!construct_wcc (&wcc, nalt, graph))
-		return false;
-	if (!(strats = allocate(double, wcc.num * nalt)))
+	/* Only allocations can fail, except for the linear programs */
+	*status = CDOR_NOMEM;
+	/* Component strategies are stored back to back, not padded to nalt */
+	if (!(strats = allocate(double, nalt)))
 		goto fail;
-	if (!(graph_wcc = allocate(cdor_bool, wcc.maxsz * wcc.maxsz)))
+	if (!(pos = allocate(size_t, wcc->num)))
 		goto fail;
-	if (!(strat_wcc = allocate(double, wcc.maxsz)))
+	if (!(graph_wcc = allocate(cdor_bool, wcc->maxsz * wcc->maxsz)))
 		goto fail;
 	strat = strats;
-	for (i = 0; i < wcc.num; i++) {
-		size_t v_wcc = 0;
-		cdor_extract_wcc (nalt, graph, wcc, i, graph_wcc);
-		if (!cdor_optimal (wcc.size[i], strat_wcc, graph_wcc))
+	for (i = 0; i < wcc->num; i++) {
+		extract (nalt, data, wcc, i, graph_wcc);
+		if (!cdor_optimal (wcc->size[i], strat, graph_wcc, status))
 			goto fail;
-		for (j = 0; j < nalt; j++)
-			strat[j] = wcc.map[j] == i ? strat_wcc[v_wcc++] : 0.0;
-		strat += nalt;
+		pos[i] = (size_t) (strat - strats);
+		strat += wcc->size[i];
 	}
-	free (graph_wcc);
-	graph_wcc = NULL;
-	if (!(term = (double *) realloc (strat_wcc, wcc.num * sizeof (double))))
-		goto fail;
-	for (i = 0; i < nalt; i++) {
-		strat = strats;
-		for (j = 0; j < wcc.num; j++) {
-			term[j] = strat[i];
-			strat += nalt;
+	/* Each alternative belongs to exactly one component */
+	*len = 0;
+	for (j = 0; j < nalt; j++) {
+		const double p = strats[pos[wcc->map[j]]++];
+		if (p > 0.0) {
+			dest[*len].alt = j;
+			dest[(*len)++].prob = p / (double) wcc->num;
 		}
-		dest[i] = cdor_sum (wcc.num, term) / (double) wcc.num;
 	}
-	free (term);
+	free (graph_wcc);
+	free (pos);
 	free (strats);
-	free (wcc.size);
-	free (wcc.map);
+	free (wcc->size);
+	free (wcc->map);
 	return true;
 fail:
-	free (term);
-	free (strat_wcc);
 	free (graph_wcc);
+	free (pos);
 	free (strats);
-	free (wcc.size);
-	free (wcc.map);
+	free (wcc->size);
+	free (wcc->map);
 	return false;
 }
 
+#ifdef __GNUC__
+__attribute__((nonnull (2, 5)))
+#endif
+static cdor_bool
+cdor_solve_components (const size_t nalt, size_t REF(len),
+                       struct cdor_prob ARR_PARAM(dest, nalt),
+                       const char ARR_PARAM(graph, nalt * nalt),
+                       enum cdor_status REF(status))
+{
+	struct wcc_data wcc;
+	*status = CDOR_NOMEM;
+	if (!construct_wcc (&wcc, nalt, graph))
+		return false;
+	return cdor_solve_wcc (nalt, len, dest, &wcc, graph_extract, graph,
+	                       status);
+}
+
+/*
+ * The functions below derive sources and components straight from the
+ * advantage graph, without building the duel graph first.  Sources are found
+ * as in cdor_find_sources, stopping at the first alternative beating each
+ * one.  Without sources, one pass over the pairs joins the alternatives of
+ * each duel with union-find, and each component reads its own duels when it
+ * is solved.
+ */
+
+static void
+duels_extract (const size_t nalt, const void * const data,
+               const struct wcc_data * const wcc, const size_t cur_wcc,
+               cdor_bool * const g_wcc)
+{
+	const cdor_adv * const duels = (const cdor_adv *) data;
+	const size_t size = wcc->size[cur_wcc];
+	size_t i = 0, wcc_i;
+	for (wcc_i = 0; wcc_i < size; wcc_i++, i++) {
+		size_t j = 0, wcc_j;
+		while (wcc->map[i] != cur_wcc)
+			i++;
+		for (wcc_j = 0; wcc_j < size; wcc_j++, j++) {
+			while (wcc->map[j] != cur_wcc)
+				j++;
+			g_wcc[wcc_i * size + wcc_j] = duels[i * nalt + j]
+			                              > duels[j * nalt + i];
+		}
+	}
+}
+
+static size_t
+duels_root (size_t ARR_PARAM(parent, 1), size_t v)
+{
+	while (parent[v] != v) {
+		parent[v] = parent[parent[v]];
+		v = parent[v];
+	}
+	return v;
+}
+
+static size_t
+duels_find_sources (const size_t nalt, cdor_bool ARR_PARAM(source, nalt),
+                    const cdor_adv ARR_PARAM(duels, nalt * nalt))
+{
+	size_t nsources = 0, i;
+	for (i = 0; i < nalt; i++) {
+		size_t j;
+		source[i] = true;
+		for (j = 0; j < nalt; j++) {
+			if (duels[j * nalt + i] > duels[i * nalt + j]) {
+				source[i] = false;
+				break;
+			}
+		}
+		if (source[i])
+			nsources++;
+	}
+	return nsources;
+}
+
+static cdor_bool
+duels_components (const size_t nalt,
+                  const cdor_adv ARR_PARAM(duels, nalt * nalt),
+                  struct wcc_data REF(wcc))
+{
+	size_t * const parent = allocate(size_t, nalt);
+	size_t i, j;
+	if (!parent)
+		return false;
+	if (!(wcc->size = zero_allocate(size_t, nalt))) {
+		free (parent);
+		return false;
+	}
+	if (!(wcc->map = allocate(size_t, nalt))) {
+		free (wcc->size);
+		free (parent);
+		return false;
+	}
+	for (i = 0; i < nalt; i++) {
+		parent[i] = i;
+		wcc->map[i] = (size_t) -1;
+	}
+	for (i = 0; i < nalt; i++) {
+		const cdor_adv * const row = duels + i * nalt;
+		for (j = i + 1; j < nalt; j++) {
+			const cdor_adv ij = row[j], ji = duels[j * nalt + i];
+			size_t ri, rj;
+			if (ij == ji)
+				continue;
+			ri = duels_root (parent, i);
+			rj = duels_root (parent, j);
+			if (ri < rj)
+				parent[rj] = ri;
+			else
+				parent[ri] = rj;
+		}
+	}
+	/* Components are numbered by their first alternative */
+	wcc->num = wcc->maxsz = 0;
+	for (i = 0; i < nalt; i++) {
+		const size_t r = duels_root (parent, i);
+		if (wcc->map[r] == (size_t) -1)
+			wcc->map[r] = wcc->num++;
+		wcc->map[i] = wcc->map[r];
+		if (++wcc->size[wcc->map[i]] > wcc->maxsz)
+			wcc->maxsz = wcc->size[wcc->map[i]];
+	}
+	free (parent);
+	return true;
+}
+
 #ifdef __GNUC__
 __attribute__((const, nonnull (1)))
 #endif
@@ -395,15 +634,39 @@ static struct cdor_strategy
 cdor_mixed_sources (const size_t nalt, const size_t nsources,
                     const cdor_bool ARR_PARAM(sources, nalt))
 {
-	struct cdor_strategy r = { CDOR_MIXED, { 0 } };
+	struct cdor_strategy r = { CDOR_SPARSE, { 0 } };
+	struct cdor_prob *supp;
 	const double coef = 1.0 / (double) nsources;
 	size_t v;
-	if (!(r.val.mixed = allocate(double, nalt))) {
+	if (!(supp = allocate(struct cdor_prob, nsources))) {
 		r.type = CDOR_ERROR;
 		return r;
 	}
-	for (v = 0; v < nalt; v++)
-		r.val.mixed[v] = sources[v] ? coef : 0.0;
+	r.val.sparse.supp = supp;
+	r.val.sparse.len = 0;
+	for (v = 0; v < nalt; v++) {
+		if (sources[v]) {
+			supp[r.val.sparse.len].alt = v;
+			supp[r.val.sparse.len++].prob = coef;
+		}
+	}
+	return r;
+}
+
+static struct cdor_strategy
+cdor_densify (const size_t nalt, const struct cdor_strategy sparse)
+{
+	struct cdor_strategy r = { CDOR_MIXED, { 0 } };
+	size_t v;
+	if (!(r.val.mixed = zero_allocate(double, nalt))) {
+		r.type = CDOR_ERROR;
+	} else {
+		for (v = 0; v < sparse.val.sparse.len; v++) {
+			const struct cdor_prob p = sparse.val.sparse.supp[v];
+			r.val.mixed[p.alt] = p.prob;
+		}
+	}
+	free (sparse.val.sparse.supp);
 	return r;
 }
 
@@ -425,18 +688,26 @@ max_election_size()
 }
 
 struct cdor_strategy
-cdor_optimal_strategy (const size_t nalt, const char * CDOR_RESTRICT graph)
+cdor_strategy_scratch (const size_t nalt, const char * CDOR_RESTRICT graph,
+                       cdor_bool * CDOR_RESTRICT scratch,
+                       enum cdor_status * CDOR_RESTRICT status)
 {
 	struct cdor_strategy r = { CDOR_ERROR, { 0 } };
+	struct cdor_prob *supp, *shrunk;
+	size_t len;
 	if (nalt == 0 || nalt > max_election_size() || graph == NULL) {
-#if _POSIX_C_SOURCE >= 1L
-		errno = EINVAL;
-#endif
+		*status = CDOR_INVALID;
 		return r;
 	}
+	/* Failures from here on are allocation failures unless told otherwise */
+	*status = CDOR_NOMEM;
+	/* Small elections were all solved at build time */
+	if (cdor_table_strategy (nalt, graph, &r))
+		goto end;
 	/* First strategy: sources */
 	{
-		cdor_bool * const sources = allocate(cdor_bool, nalt);
+		cdor_bool * const sources = scratch ? scratch :
+			allocate(cdor_bool, nalt);
 		size_t nsources;
 		if (!sources)
 			return r;
@@ -444,18 +715,161 @@ cdor_optimal_strategy (const size_t nalt, const char * CDOR_RESTRICT graph)
 		if (nsources > 0) {
 			r = nsources == 1 ? cdor_one_source (sources) :
 				cdor_mixed_sources (nalt, nsources, sources);
-			free (sources);
-			return r;
+			if (!scratch)
+				free (sources);
+			goto end;
 		}
-		free (sources);
+		if (!scratch)
+			free (sources);
 	}
 	/* Second strategy: weakly-connected components */
-	if (!(r.val.mixed = allocate(double, nalt)))
+	if (!(supp = allocate(struct cdor_prob, nalt)))
+		return r;
+	if (!cdor_solve_components (nalt, &len, supp, graph, status)) {
+		free (supp);
+		return r;
+	}
+	if (len > 0 && (shrunk = (struct cdor_prob *)
+	                realloc (supp, len * sizeof (struct cdor_prob))))
+		supp = shrunk;
+	r.type = CDOR_SPARSE;
+	r.val.sparse.len = len;
+	r.val.sparse.supp = supp;
+end:
+	if (r.type != CDOR_ERROR)
+		*status = CDOR_OK;
+	return r;
+}
+
+/*
+ * Room for the duel graph of the elections the table covers, which it needs
+ * to look them up.  No table covers more: it would have 3^28 entries.
+ */
+#define DUELS_TABLE 8
+
+static struct cdor_strategy
+duels_strategy (const size_t nalt, const cdor_adv * CDOR_RESTRICT duels,
+                enum cdor_status REF(status))
+{
+	struct cdor_strategy r = { CDOR_ERROR, { 0 } };
+	struct wcc_data wcc;
+	struct cdor_prob *supp, *shrunk;
+	cdor_bool *sources;
+	size_t nsources, len, i;
+	if (nalt == 0 || nalt > max_election_size() || duels == NULL) {
+		*status = CDOR_INVALID;
+		return r;
+	}
+	*status = CDOR_NOMEM;
+	if (nalt <= cdor_table_max && nalt <= DUELS_TABLE) {
+		char graph[DUELS_TABLE * DUELS_TABLE];
+		size_t j;
+		for (i = 0; i < nalt; i++) {
+			for (j = 0; j < nalt; j++)
+				graph[i * nalt + j] = duels[i * nalt + j]
+				                      > duels[j * nalt + i];
+		}
+		if (cdor_table_strategy (nalt, graph, &r))
+			goto end;
+	}
+	if (!(sources = allocate(cdor_bool, nalt)))
+		return r;
+	nsources = duels_find_sources (nalt, sources, duels);
+	if (nsources > 0)
+		r = nsources == 1 ? cdor_one_source (sources) :
+			cdor_mixed_sources (nalt, nsources, sources);
+	free (sources);
+	if (nsources > 0)
+		goto end;
+	if (!duels_components (nalt, duels, &wcc))
+		return r;
+	if (!(supp = allocate(struct cdor_prob, nalt))) {
+		free (wcc.size);
+		free (wcc.map);
+		return r;
+	}
+	if (!cdor_solve_wcc (nalt, &len, supp, &wcc, duels_extract, duels,
+	                     status)) {
+		free (supp);
 		return r;
-	if (cdor_solve_components (nalt, r.val.mixed, graph))
-		r.type = CDOR_MIXED;
-	else
-		free (r.val.mixed);
+	}
+	if (len > 0 && (shrunk = (struct cdor_prob *)
+	                realloc (supp, len * sizeof (struct cdor_prob))))
+		supp = shrunk;
+	r.type = CDOR_SPARSE;
+	r.val.sparse.len = len;
+	r.val.sparse.supp = supp;
+end:
+	if (r.type != CDOR_ERROR)
+		*status = CDOR_OK;
+	return r;
+}
+
+enum cdor_status
+cdor_compute_strategy (const size_t nalt, const char * CDOR_RESTRICT graph,
+                       struct cdor_strategy * CDOR_RESTRICT result)
+{
+	enum cdor_status status;
+	*result = cdor_strategy_scratch (nalt, graph, NULL, &status);
+	return status;
+}
+
+const char *
+cdor_status_string (const enum cdor_status status)
+{
+	switch (status) {
+	case CDOR_OK:
+		return "Success";
+	case CDOR_INVALID:
+		return "Invalid election";
+	case CDOR_NOMEM:
+		return "Out of memory";
+	case CDOR_UNSOLVED:
+		return "Linear program could not be solved";
+	}
+	return "Unknown status";
+}
+
+/* Legacy entry points report failures through errno */
+void
+cdor_status_errno (const enum cdor_status status)
+{
+	switch (status) {
+	case CDOR_OK:
+		break;
+	case CDOR_INVALID:
+		set_errno (EINVAL);
+		break;
+	case CDOR_NOMEM:
+		set_errno (ENOMEM);
+		break;
+	case CDOR_UNSOLVED:
+		set_errno (EDOM);
+		break;
+	}
+}
+
+struct cdor_strategy
+cdor_sparse_strategy (const size_t nalt, const char * CDOR_RESTRICT graph)
+{
+	struct cdor_strategy r;
+	cdor_status_errno (cdor_compute_strategy (nalt, graph, &r));
+	return r;
+}
+
+struct cdor_strategy
+cdor_optimal_strategy (const size_t nalt, const char * CDOR_RESTRICT graph)
+{
+	const struct cdor_strategy r = cdor_sparse_strategy (nalt, graph);
+	return r.type == CDOR_SPARSE ? cdor_densify (nalt, r) : r;
+}
+
+struct cdor_strategy
+cdor_duels_strategy (const size_t nalt, const cdor_adv * CDOR_RESTRICT duels)
+{
+	enum cdor_status status;
+	const struct cdor_strategy r = duels_strategy (nalt, duels, &status);
+	cdor_status_errno (status);
 	return r;
 }
 
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <errno.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "condor.h"
+#include "util.h"
+
+/*
+ * When ballots are drawn uniformly without replacement from a population of
+ * N, the margin m of a pair after k draws estimates the final margin.  By
+ * Serfling's inequality, each ballot adding -1, 0 or 1, the final margin has
+ * the other sign, or is 0, with probability at most d / 2 once
+ *
+ *   |m| > sqrt (2 k (1 - (k - 1) / N) ln (2 / d)).
+ *
+ * The risk is split among the pairs and, so that checking as often as one
+ * likes is sound, among the checks: the c-th check gets risk / (c (c + 1))
+ * since these add up to risk.  Besides, a pair is settled for sure when the
+ * remaining ballots could not overturn its margin.
+ */
+
+/* Ballots cast between two checks by cdor_sample_ballots */
+#define SAMPLE_CHECK 256
+
+struct cdor_sample {
+	size_t nalt;
+	size_t population;
+	size_t count;
+	unsigned long checks;
+	double risk;
+	cdor_margin *margins;
+};
+
+struct cdor_sample *
+cdor_sample_new (const size_t nalt, const size_t population,
+                 const double risk)
+{
+	struct cdor_sample *s;
+	if (nalt == 0 || population == 0 || !(risk > 0.0 && risk < 1.0)
+	    || nalt > (size_t) -1 / sizeof (cdor_margin) / nalt) {
+		set_errno (EINVAL);
+		return NULL;
+	}
+	if (!(s = allocate(struct cdor_sample, 1)))
+		return NULL;
+	/* One spare element so that a single alternative allocates something */
+	if (!(s->margins = zero_allocate(cdor_margin,
+	                                 cdor_margin_size (nalt) + 1))) {
+		free (s);
+		return NULL;
+	}
+	s->nalt = nalt;
+	s->population = population;
+	s->count = 0;
+	s->checks = 0;
+	s->risk = risk;
+	return s;
+}
+
+void
+cdor_sample_free (struct cdor_sample * const s)
+{
+	if (!s)
+		return;
+	free (s->margins);
+	free (s);
+}
+
+int
+cdor_sample_ranking (struct cdor_sample * CDOR_RESTRICT const s,
+                     const size_t * CDOR_RESTRICT const rank)
+{
+	if (s->count == s->population) {
+		set_errno (ERANGE);
+		return -1;
+	}
+	cdor_cast_margin_ranking (s->nalt, s->margins, rank, 1);
+	s->count++;
+	return 0;
+}
+
+int
+cdor_sample_settled (struct cdor_sample * CDOR_RESTRICT const s,
+                     char * CDOR_RESTRICT const graph)
+{
+	const size_t npairs = cdor_margin_size (s->nalt);
+	const double k = (double) s->count, n = (double) s->population;
+	const double c = (double) ++s->checks;
+	double bound = (double) (s->population - s->count);
+	size_t i;
+	if (npairs > 0 && s->count > 0 && s->count < s->population) {
+		const double d = log (2.0 / s->risk) + log ((double) npairs)
+		                 + log (c) + log (c + 1.0);
+		const double stat = sqrt (2.0 * k * (1.0 - (k - 1.0) / n) * d);
+		if (stat < bound)
+			bound = stat;
+	}
+	for (i = 0; i < npairs; i++) {
+		const double m = (double) s->margins[i];
+		if (!(m > bound || -m > bound || s->count == s->population))
+			return 0;
+	}
+	if (graph)
+		cdor_make_margin_graph (s->nalt, graph, s->margins);
+	return 1;
+}
+
+size_t
+cdor_sample_count (const struct cdor_sample * const s)
+{
+	return s->count;
+}
+
+/* Xorshift generator, kept to 32 bits whatever the width of long */
+static unsigned long
+sample_draw (unsigned long REF(state))
+{
+	unsigned long x = *state;
+	x ^= x << 13 & 0xffffffffUL;
+	x ^= x >> 17;
+	x ^= x << 5 & 0xffffffffUL;
+	return *state = x;
+}
+
+/* Uniform in [0, m), by rejection */
+static size_t
+sample_below (unsigned long REF(state), const size_t m)
+{
+	for (;;) {
+		size_t v = 0, max = 0;
+		do {
+			v = v << 16 << 16 | (size_t) sample_draw (state);
+			max = max << 16 << 16 | (size_t) 0xffffffffUL;
+		} while (max < m - 1);
+		if (v - v % m <= max - (m - 1))
+			return v % m;
+	}
+}
+
+int
+cdor_sample_ballots (const size_t nalt, const size_t nballots,
+                     const size_t * CDOR_RESTRICT const ranks,
+                     const double risk, const unsigned long seed,
+                     char * CDOR_RESTRICT const graph,
+                     size_t * CDOR_RESTRICT const count)
+{
+	struct cdor_sample *s;
+	size_t *order, i;
+	unsigned long state = seed & 0xffffffffUL;
+	if (nballots > (size_t) -1 / sizeof (size_t)) {
+		set_errno (EINVAL);
+		return -1;
+	}
+	if (!(s = cdor_sample_new (nalt, nballots, risk)))
+		return -1;
+	if (!(order = allocate(size_t, nballots))) {
+		cdor_sample_free (s);
+		return -1;
+	}
+	if (state == 0)
+		state = 2463534242UL;
+	for (i = 0; i < nballots; i++)
+		order[i] = i;
+	/* Fisher-Yates, only as far as ballots are needed */
+	for (i = 0; i < nballots; i++) {
+		const size_t j = i + sample_below (&state, nballots - i);
+		const size_t b = order[j];
+		order[j] = order[i];
+		order[i] = b;
+		cdor_sample_ranking (s, ranks + b * nalt);
+		if ((i + 1) % SAMPLE_CHECK == 0 && cdor_sample_settled (s, graph))
+			break;
+	}
+	if (i == nballots)
+		cdor_sample_settled (s, graph);
+	if (count)
+		*count = cdor_sample_count (s);
+	free (order);
+	cdor_sample_free (s);
+	return 0;
+}
@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "condor.h"
+#include "util.h"
+
+#if _POSIX_C_SOURCE >= 200112L
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Counters are updated from several processes, so they must be lock free
+ * rather than merely atomic.  Only the GCC builtins, which Clang provides too,
+ * are used: C11 atomics would need the counters of the file to be declared
+ * _Atomic, whose representation need not be that of cdor_adv.
+ */
+#if defined __GCC_ATOMIC_LLONG_LOCK_FREE && __GCC_ATOMIC_LLONG_LOCK_FREE == 2
+#define SHARED_ATOMICS 1
+#define shared_add(p, v) ((void) __atomic_fetch_add (p, v, __ATOMIC_RELAXED))
+#define shared_read(p) __atomic_load_n (p, __ATOMIC_RELAXED)
+#define shared_acquire(p) __atomic_load_n (p, __ATOMIC_ACQUIRE)
+#define shared_next(p) __atomic_fetch_add (p, 1, __ATOMIC_RELAXED)
+#define shared_done(p) ((void) __atomic_fetch_add (p, 1, __ATOMIC_RELEASE))
+#define shared_fence_release() __atomic_thread_fence (__ATOMIC_RELEASE)
+#define shared_fence_acquire() __atomic_thread_fence (__ATOMIC_ACQUIRE)
+#else
+/* Never reached since cdor_shared_open fails */
+#define shared_add(p, v) ((void) (*(p) += (v)))
+#define shared_read(p) (*(p))
+#define shared_acquire(p) (*(p))
+#define shared_next(p) ((*(p))++)
+#define shared_done(p) ((void) ++*(p))
+#define shared_fence_release() ((void) 0)
+#define shared_fence_acquire() ((void) 0)
+#endif
+
+/*
+ * Layout of the shared file, in counters of type cdor_adv:
+ *  0  magic number
+ *  1  number of alternatives
+ *  2  number of stripes
+ *  3  counters per row, padded to whole cache lines
+ *  4  number of handles opened, which picks their stripe
+ *  8  stripes, each starting on a cache line
+ * Each handle casts into its own stripe, so that processes tallying the same
+ * ballots do not fight over cache lines, and snapshots add the stripes up.
+ *
+ * Each stripe starts with a cache line counting the casts begun and ended in
+ * it, followed by its advantage graph.  They work like a sequence lock with
+ * several writers: a snapshot only keeps what it read from a stripe if no
+ * cast was in progress when it started, and none began before it ended.
+ * Nothing ever waits for a cast: a snapshot retries a busy stripe a few times
+ * and then makes do with what it read, so that a process killed while casting
+ * only costs later snapshots their guarantee of whole ballots.
+ */
+#define SHARED_LINE 8
+#define SHARED_DATA 8
+#define SHARED_BEGUN 0
+#define SHARED_ENDED 1
+#define SHARED_RETRIES 64
+
+struct cdor_shared {
+	cdor_adv *base;
+	size_t len;
+	size_t nalt;
+	size_t stride;
+	cdor_adv *stripe;
+};
+
+static cdor_adv
+shared_magic (void)
+{
+	/* "CDORSHM2" without 64-bit constants, which C89 lacks */
+	return (cdor_adv) 0x43444f52UL << 16 << 16 | (cdor_adv) 0x53484d32UL;
+}
+
+/* Total counters of the file, or 0 on overflow */
+static size_t
+shared_size (const size_t nalt, const size_t stripes, const size_t stride)
+{
+	const size_t max = (size_t) -1 / sizeof (cdor_adv) - SHARED_DATA;
+	if (stride == 0 || nalt > (max - SHARED_LINE) / stride
+	    || stripes > max / (SHARED_LINE + nalt * stride))
+		return 0;
+	return SHARED_DATA + stripes * (SHARED_LINE + nalt * stride);
+}
+
+static cdor_adv *
+shared_stripe (const struct cdor_shared REF(s), const size_t k)
+{
+	return s->base + SHARED_DATA + k * (SHARED_LINE + s->nalt * s->stride);
+}
+
+static cdor_bool
+shared_map (struct cdor_shared REF(s), const int fd, const size_t len)
+{
+	void * const base = mmap (NULL, len * sizeof (cdor_adv),
+	                          PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED)
+		return false;
+	s->base = (cdor_adv *) base;
+	s->len = len;
+	return true;
+}
+
+/*
+ * Sets the file up under a temporary name, then links it to path, so that
+ * the file at path is always complete, even if the creator dies.  Returns
+ * whether another file was there first.
+ */
+static cdor_bool
+shared_create (struct cdor_shared REF(s), const char * CDOR_RESTRICT path,
+               const size_t nalt, const size_t stripes, cdor_bool REF(ok))
+{
+	const size_t stride = (nalt + SHARED_LINE - 1) / SHARED_LINE * SHARED_LINE;
+	const size_t len = shared_size (nalt, stripes, stride);
+	const size_t plen = strlen (path);
+	cdor_bool exists = false;
+	char *tmp;
+	int fd, e;
+	*ok = false;
+	if (len == 0) {
+		errno = EINVAL;
+		return false;
+	}
+	/* Unique among the handles of all processes being opened */
+	if (!(tmp = allocate(char, plen + 2 * sizeof (unsigned long) * 2 + 4)))
+		return false;
+	sprintf (tmp, "%s.%lx.%lx", path, (unsigned long) getpid (),
+	         (unsigned long) (size_t) s);
+	if ((fd = open (tmp, O_RDWR | O_CREAT | O_EXCL, 0666)) < 0) {
+		free (tmp);
+		return false;
+	}
+	if (ftruncate (fd, (off_t) (len * sizeof (cdor_adv))) == 0
+	    && shared_map (s, fd, len)) {
+		/* The file is zero-filled, so only the header is written */
+		s->base[0] = shared_magic ();
+		s->base[1] = nalt;
+		s->base[2] = stripes;
+		s->base[3] = stride;
+		if (link (tmp, path) == 0)
+			*ok = true;
+		else
+			exists = errno == EEXIST;
+		if (!*ok)
+			munmap (s->base, len * sizeof (cdor_adv));
+	}
+	e = errno;
+	unlink (tmp);
+	close (fd);
+	free (tmp);
+	errno = e;
+	return exists;
+}
+
+static cdor_bool
+shared_attach (struct cdor_shared REF(s), const char * CDOR_RESTRICT path,
+               const size_t nalt)
+{
+	struct stat st;
+	const int fd = open (path, O_RDWR);
+	cdor_bool ok = false;
+	size_t len;
+	if (fd < 0)
+		return false;
+	errno = EINVAL;
+	if (fstat (fd, &st) == 0
+	    && st.st_size >= (off_t) (SHARED_DATA * sizeof (cdor_adv))
+	    && shared_map (s, fd, (size_t) st.st_size / sizeof (cdor_adv))) {
+		if (shared_acquire (s->base) != shared_magic ()
+		    || s->base[1] != nalt || s->base[2] == 0
+		    || (len = shared_size (nalt, (size_t) s->base[2],
+		                           (size_t) s->base[3])) == 0
+		    || len != s->len) {
+			errno = EINVAL;
+		} else {
+			ok = true;
+		}
+		if (!ok)
+			munmap (s->base, s->len * sizeof (cdor_adv));
+	}
+	close (fd);
+	return ok;
+}
+
+struct cdor_shared *
+cdor_shared_open (const char * CDOR_RESTRICT const path, const size_t nalt,
+                  const unsigned stripes)
+{
+	struct cdor_shared *s;
+	cdor_bool ok;
+#ifndef SHARED_ATOMICS
+	errno = ENOSYS;
+	return NULL;
+#endif
+	if (nalt == 0 || stripes == 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (!(s = allocate(struct cdor_shared, 1)))
+		return NULL;
+	if (shared_create (s, path, nalt, stripes, &ok))
+		ok = shared_attach (s, path, nalt);
+	if (!ok) {
+		free (s);
+		return NULL;
+	}
+	s->nalt = nalt;
+	s->stride = (size_t) s->base[3];
+	s->stripe = shared_stripe (s, (size_t) (shared_next (s->base + 4)
+	                                        % s->base[2]));
+	return s;
+}
+
+int
+cdor_shared_close (struct cdor_shared * const s)
+{
+	const int r = munmap (s->base, s->len * sizeof (cdor_adv));
+	free (s);
+	return r;
+}
+
+/* Returns the advantage graph of the stripe, once announced */
+static cdor_adv *
+shared_begin_cast (const struct cdor_shared REF(s))
+{
+	shared_add (s->stripe + SHARED_BEGUN, 1);
+	/* Orders the announcement before the increments */
+	shared_fence_release ();
+	return s->stripe + SHARED_LINE;
+}
+
+void
+cdor_shared_ranking (struct cdor_shared * CDOR_RESTRICT const s,
+                     const size_t * CDOR_RESTRICT const rank,
+                     const cdor_adv weight)
+{
+	const size_t nalt = s->nalt;
+	cdor_adv *duels;
+	size_t i, j, worst = 0;
+	if (weight == 0)
+		return;
+	for (i = 0; i < nalt; i++) {
+		if (rank[i] > worst)
+			worst = rank[i];
+	}
+	duels = shared_begin_cast (s);
+	for (i = 0; i < nalt; i++) {
+		cdor_adv * const row = duels + i * s->stride;
+		if (rank[i] == worst)
+			continue;
+		for (j = 0; j < nalt; j++) {
+			if (rank[i] < rank[j])
+				shared_add (row + j, weight);
+		}
+	}
+	shared_done (s->stripe + SHARED_ENDED);
+}
+
+void
+cdor_shared_add_duels (struct cdor_shared * CDOR_RESTRICT const s,
+                       const cdor_adv * CDOR_RESTRICT const duels)
+{
+	const size_t nalt = s->nalt;
+	cdor_adv * const dest = shared_begin_cast (s);
+	size_t i, j;
+	for (i = 0; i < nalt; i++) {
+		cdor_adv * const row = dest + i * s->stride;
+		for (j = 0; j < nalt; j++) {
+			if (duels[i * nalt + j] != 0)
+				shared_add (row + j, duels[i * nalt + j]);
+		}
+	}
+	shared_done (s->stripe + SHARED_ENDED);
+}
+
+/* Reads stripe k into copy, returning whether it holds whole ballots */
+static cdor_bool
+shared_read_stripe (const struct cdor_shared REF(s), const size_t k,
+                    cdor_adv ARR_PARAM(copy, 1))
+{
+	const size_t nalt = s->nalt;
+	const cdor_adv * const stripe = shared_stripe (s, k);
+	unsigned tries;
+	for (tries = 0;; tries++) {
+		const cdor_adv ended = shared_acquire (stripe + SHARED_ENDED);
+		const cdor_adv begun = shared_read (stripe + SHARED_BEGUN);
+		const cdor_bool last = tries == SHARED_RETRIES;
+		size_t i, j;
+		if (begun == ended || last) {
+			for (i = 0; i < nalt; i++) {
+				const cdor_adv * const row = stripe + SHARED_LINE
+				                             + i * s->stride;
+				for (j = 0; j < nalt; j++)
+					copy[i * nalt + j] = shared_read (row + j);
+			}
+			/* Casts whose increments were read are now seen begun */
+			shared_fence_acquire ();
+			if (begun == ended
+			    && shared_read (stripe + SHARED_BEGUN) == begun)
+				return true;
+			if (last)
+				return false;
+		}
+		sched_yield ();
+	}
+}
+
+int
+cdor_shared_snapshot (struct cdor_shared * CDOR_RESTRICT const s,
+                      cdor_adv * CDOR_RESTRICT const duels)
+{
+	const size_t nalt = s->nalt, stripes = (size_t) s->base[2];
+	cdor_adv * const copy = allocate(cdor_adv, nalt * nalt);
+	cdor_bool whole = true;
+	size_t k, i;
+	if (!copy)
+		return -1;
+	for (i = 0; i < nalt * nalt; i++)
+		duels[i] = 0;
+	for (k = 0; k < stripes; k++) {
+		if (!shared_read_stripe (s, k, copy))
+			whole = false;
+		for (i = 0; i < nalt * nalt; i++)
+			duels[i] += copy[i];
+	}
+	free (copy);
+	return !whole;
+}
+#endif
@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if _POSIX_C_SOURCE >= 200112L
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "condor.h"
+#include "util.h"
+
+/*
+ * Snapshot layout, all header integers being little-endian:
+ *  0  magic "CDORDUEL"
+ *  8  format version
+ *  9  counter width in bytes
+ * 10  counter byte order (0 little-endian, 1 big-endian)
+ * 11  kind (SNAP_FULL or SNAP_DELTA)
+ * 12  32-bit FNV-1a checksum of the payload
+ * 16  number of alternatives
+ * 24  number of delta records (zero for full snapshots)
+ * 32  payload of counters in their native representation
+ * A full payload is the n * n duel matrix.  A delta payload is a sequence of
+ * (cell index, count) pairs of counters with strictly increasing indices.
+ */
+#define SNAP_HEADER 32
+#define SNAP_VERSION 1
+
+enum { SNAP_FULL, SNAP_DELTA };
+
+struct snap_header {
+	size_t nalt;
+	size_t nrec;
+	unsigned long sum;
+	int kind;
+};
+
+static const unsigned char snap_magic[8] = {
+	'C', 'D', 'O', 'R', 'D', 'U', 'E', 'L'
+};
+
+static unsigned char
+snap_byte_order (void)
+{
+	const cdor_adv one = 1;
+	return *(const unsigned char *) &one == 0;
+}
+
+static unsigned long
+snap_checksum (unsigned long h, const size_t len,
+               const void * CDOR_RESTRICT const buf)
+{
+	const unsigned char * const b = (const unsigned char *) buf;
+	size_t i;
+	for (i = 0; i < len; i++)
+		h = ((h ^ b[i]) * 16777619UL) & 0xffffffffUL;
+	return h;
+}
+
+#define SNAP_CHECKSUM_INIT 2166136261UL
+
+static void
+snap_put (unsigned char ARR_PARAM(p, 8), size_t v, const unsigned n)
+{
+	unsigned i;
+	for (i = 0; i < n; i++) {
+		p[i] = (unsigned char) (v & 0xffu);
+		v >>= 8;
+	}
+}
+
+static cdor_bool
+snap_get (size_t REF(v), const unsigned char ARR_PARAM(p, 8), unsigned n)
+{
+	*v = 0;
+	while (n-- > 0) {
+		if (*v > (size_t) -1 >> 8)
+			return false;
+		*v = *v << 8 | p[n];
+	}
+	return true;
+}
+
+static size_t
+snap_cells (const size_t nalt)
+{
+	if (nalt > 0 && nalt > (size_t) -1 / sizeof (cdor_adv) / nalt)
+		return 0;
+	return nalt * nalt;
+}
+
+static size_t
+snap_payload_size (const struct snap_header REF(h))
+{
+	if (h->kind == SNAP_FULL)
+		return snap_cells (h->nalt) * sizeof (cdor_adv);
+	return h->nrec * 2 * sizeof (cdor_adv);
+}
+
+static void
+snap_encode (unsigned char ARR_PARAM(buf, SNAP_HEADER),
+             const struct snap_header REF(h))
+{
+	memcpy (buf, snap_magic, sizeof snap_magic);
+	buf[8] = SNAP_VERSION;
+	buf[9] = (unsigned char) sizeof (cdor_adv);
+	buf[10] = snap_byte_order ();
+	buf[11] = (unsigned char) h->kind;
+	snap_put (buf + 12, h->sum, 4);
+	snap_put (buf + 16, h->nalt, 8);
+	snap_put (buf + 24, h->nrec, 8);
+}
+
+static cdor_bool
+snap_decode (struct snap_header REF(h),
+             const unsigned char ARR_PARAM(buf, SNAP_HEADER))
+{
+	size_t sum;
+	if (memcmp (buf, snap_magic, sizeof snap_magic) != 0
+	    || buf[8] != SNAP_VERSION || buf[9] != sizeof (cdor_adv)
+	    || buf[10] != snap_byte_order () || buf[11] > SNAP_DELTA)
+		return false;
+	h->kind = buf[11];
+	if (!snap_get (&sum, buf + 12, 4) || !snap_get (&h->nalt, buf + 16, 8)
+	    || !snap_get (&h->nrec, buf + 24, 8))
+		return false;
+	h->sum = (unsigned long) sum;
+	if (h->nalt > 0 && snap_cells (h->nalt) == 0)
+		return false;
+	if (h->kind == SNAP_FULL ? h->nrec != 0
+	    : h->nrec > snap_cells (h->nalt)
+	      || h->nrec > (size_t) -1 / (2 * sizeof (cdor_adv)))
+		return false;
+	return true;
+}
+
+static int
+snap_write_header (FILE REF(f), const struct snap_header REF(h))
+{
+	unsigned char buf[SNAP_HEADER];
+	snap_encode (buf, h);
+	return fwrite (buf, 1, SNAP_HEADER, f) == SNAP_HEADER ? 0 : -1;
+}
+
+int
+cdor_save_duels (FILE * CDOR_RESTRICT const f, const size_t nalt,
+                 const cdor_adv * CDOR_RESTRICT const duels)
+{
+	struct snap_header h;
+	const size_t n = snap_cells (nalt);
+	if (nalt > 0 && n == 0) {
+		set_errno (EINVAL);
+		return -1;
+	}
+	h.nalt = nalt;
+	h.nrec = 0;
+	h.kind = SNAP_FULL;
+	h.sum = snap_checksum (SNAP_CHECKSUM_INIT, n * sizeof *duels, duels);
+	if (snap_write_header (f, &h) < 0 || fwrite (duels, sizeof *duels, n, f) != n)
+		return -1;
+	return 0;
+}
+
+int
+cdor_save_delta (FILE * CDOR_RESTRICT const f, const size_t nalt,
+                 const cdor_adv * CDOR_RESTRICT const duels)
+{
+	struct snap_header h;
+	const size_t n = snap_cells (nalt);
+	cdor_adv rec[2];
+	size_t i;
+	if (nalt > 0 && n == 0) {
+		set_errno (EINVAL);
+		return -1;
+	}
+	h.nalt = nalt;
+	h.nrec = 0;
+	h.kind = SNAP_DELTA;
+	h.sum = SNAP_CHECKSUM_INIT;
+	/* First pass to compute the header, the stream may not be seekable */
+	for (i = 0; i < n; i++) {
+		if (duels[i] == 0)
+			continue;
+		rec[0] = i;
+		rec[1] = duels[i];
+		h.sum = snap_checksum (h.sum, sizeof rec, rec);
+		h.nrec++;
+	}
+	if (snap_write_header (f, &h) < 0)
+		return -1;
+	for (i = 0; i < n; i++) {
+		if (duels[i] == 0)
+			continue;
+		rec[0] = i;
+		rec[1] = duels[i];
+		if (fwrite (rec, sizeof rec[0], 2, f) != 2)
+			return -1;
+	}
+	return 0;
+}
+
+static cdor_adv *
+snap_read (FILE REF(f), struct snap_header REF(h))
+{
+	unsigned char buf[SNAP_HEADER];
+	cdor_adv *payload;
+	size_t size;
+	if (fread (buf, 1, SNAP_HEADER, f) != SNAP_HEADER)
+		goto invalid;
+	if (!snap_decode (h, buf))
+		goto invalid;
+	size = snap_payload_size (h);
+	/* Allocate at least one counter so that NULL always means failure */
+	if (!(payload = allocate(cdor_adv, size / sizeof (cdor_adv) + 1)))
+		return NULL;
+	if (fread (payload, 1, size, f) != size
+	    || snap_checksum (SNAP_CHECKSUM_INIT, size, payload) != h->sum) {
+		free (payload);
+		goto invalid;
+	}
+	return payload;
+invalid:
+	set_errno (EINVAL);
+	return NULL;
+}
+
+/* Adds the payload into duels, leaving it untouched on failure */
+static cdor_bool
+snap_apply (const struct snap_header REF(h),
+            cdor_adv * CDOR_RESTRICT const duels,
+            const cdor_adv * CDOR_RESTRICT const payload)
+{
+	const size_t n = snap_cells (h->nalt);
+	size_t i;
+	if (h->kind == SNAP_FULL)
+		return cdor_add_duels (h->nalt, duels, payload) == 0;
+	for (i = 0; i < h->nrec; i++) {
+		const cdor_adv cell = payload[2 * i];
+		if (cell >= n || (i > 0 && cell <= payload[2 * i - 2])) {
+			set_errno (EINVAL);
+			return false;
+		}
+		if (duels[cell] > (cdor_adv) -1 - payload[2 * i + 1]) {
+			set_errno (ERANGE);
+			return false;
+		}
+	}
+	for (i = 0; i < h->nrec; i++)
+		duels[payload[2 * i]] += payload[2 * i + 1];
+	return true;
+}
+
+cdor_adv *
+cdor_load_duels (FILE * CDOR_RESTRICT const f, size_t * CDOR_RESTRICT const nalt)
+{
+	struct snap_header h;
+	cdor_adv *payload, *duels;
+	if (!(payload = snap_read (f, &h)))
+		return NULL;
+	if (h.kind == SNAP_FULL) {
+		*nalt = h.nalt;
+		return payload;
+	}
+	if (!(duels = zero_allocate(cdor_adv, snap_cells (h.nalt) + 1))) {
+		free (payload);
+		return NULL;
+	}
+	if (!snap_apply (&h, duels, payload)) {
+		free (duels);
+		duels = NULL;
+	} else {
+		*nalt = h.nalt;
+	}
+	free (payload);
+	return duels;
+}
+
+int
+cdor_merge_duels (FILE * CDOR_RESTRICT const f, const size_t nalt,
+                  cdor_adv * CDOR_RESTRICT const duels)
+{
+	struct snap_header h;
+	cdor_adv *payload;
+	cdor_bool ok;
+	if (!(payload = snap_read (f, &h)))
+		return -1;
+	if (h.nalt != nalt) {
+		free (payload);
+		set_errno (EINVAL);
+		return -1;
+	}
+	ok = snap_apply (&h, duels, payload);
+	free (payload);
+	return ok ? 0 : -1;
+}
+
+#if _POSIX_C_SOURCE >= 200112L
+const cdor_adv *
+cdor_map_duels (const int fd, size_t * CDOR_RESTRICT const nalt)
+{
+	struct stat st;
+	struct snap_header h;
+	unsigned char *base;
+	size_t len;
+	if (fstat (fd, &st) < 0)
+		return NULL;
+	len = (size_t) st.st_size;
+	if (st.st_size < SNAP_HEADER || (off_t) len != st.st_size) {
+		errno = EINVAL;
+		return NULL;
+	}
+	base = (unsigned char *) mmap (NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED)
+		return NULL;
+	if (!snap_decode (&h, base) || h.kind != SNAP_FULL
+	    || len - SNAP_HEADER != snap_payload_size (&h)
+	    || snap_checksum (SNAP_CHECKSUM_INIT, len - SNAP_HEADER,
+	                      base + SNAP_HEADER) != h.sum) {
+		munmap (base, len);
+		errno = EINVAL;
+		return NULL;
+	}
+	*nalt = h.nalt;
+	return (const cdor_adv *) (const void *) (base + SNAP_HEADER);
+}
+
+int
+cdor_unmap_duels (const size_t nalt, const cdor_adv * const duels)
+{
+	const unsigned char * const base =
+		(const unsigned char *) duels - SNAP_HEADER;
+	return munmap ((void *) base,
+	               SNAP_HEADER + nalt * nalt * sizeof (cdor_adv));
+}
+#endif
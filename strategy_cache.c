@@ -0,0 +1,515 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "condor.h"
+#include "util.h"
+
+#ifdef CDOR_THREADS
+#include <pthread.h>
+#endif
+
+/*
+ * Ties left after color refinement are broken by trying every order within
+ * each class of alternatives, as long as there are at most CACHE_PERMS orders
+ * in total.  Beyond that, they are broken by index, so isomorphic graphs may
+ * miss each other but never collide.
+ */
+#define CACHE_PERMS 5040
+
+#define NONE ((size_t) -1)
+
+/*
+ * Strategies are stored relative to the canonical labeling of their graph, in
+ * entries that are chained both in hash buckets and in least-recently-used
+ * order.
+ */
+struct cache_entry {
+	size_t hash;
+	size_t nalt;
+	char *key;
+	struct cdor_strategy strat;
+	size_t chain;
+	size_t prev;
+	size_t next;
+};
+
+struct cdor_strategy_cache {
+	size_t cap;
+	size_t len;
+	size_t mask;
+	size_t *bucket;
+	struct cache_entry *entry;
+	/* Most and least recently used entries */
+	size_t head;
+	size_t tail;
+	unsigned long hits;
+	unsigned long misses;
+#ifdef CDOR_THREADS
+	pthread_mutex_t lock;
+#endif
+};
+
+/* Canonical labeling: alternative order[c] of the graph is labeled c */
+struct canon {
+	size_t nalt;
+	size_t *order;
+	char *graph;
+	char *cand;
+	size_t *color;
+	size_t *sig;
+};
+
+static size_t
+canon_mix (size_t x)
+{
+	x ^= x >> 15;
+	x *= 2246822519UL;
+	return x ^ x >> 13;
+}
+
+/* Sorts alternatives by signature, ties by index, and ranks the signatures */
+static size_t
+canon_recolor (struct canon REF(c))
+{
+	size_t ncolors = 0, k;
+	for (k = 0; k < c->nalt; k++) {
+		const size_t v = k;
+		size_t j = k;
+		while (j > 0 && c->sig[c->order[j - 1]] > c->sig[v]) {
+			c->order[j] = c->order[j - 1];
+			j--;
+		}
+		c->order[j] = v;
+	}
+	for (k = 0; k < c->nalt; k++) {
+		if (k > 0 && c->sig[c->order[k]] != c->sig[c->order[k - 1]])
+			ncolors++;
+		c->color[c->order[k]] = ncolors;
+	}
+	return ncolors + 1;
+}
+
+/* Splits alternatives by how they relate to each color until it is stable */
+static void
+canon_refine (struct canon REF(c), const char * CDOR_RESTRICT const graph)
+{
+	const size_t n = c->nalt;
+	size_t ncolors, round, i, j;
+	for (i = 0; i < n; i++)
+		c->sig[i] = 0;
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < n; j++) {
+			if (graph[i * n + j]) {
+				c->sig[i] += (size_t) 1 << 16;
+				c->sig[j]++;
+			}
+		}
+	}
+	ncolors = canon_recolor (c);
+	for (round = 0; round < n; round++) {
+		size_t next;
+		for (i = 0; i < n; i++) {
+			size_t s = canon_mix (c->color[i]);
+			for (j = 0; j < n; j++) {
+				const size_t rel = (size_t) (graph[i * n + j] != 0)
+				                   + 2 * (size_t) (graph[j * n + i] != 0);
+				s += canon_mix (4 * c->color[j] + rel + 1);
+			}
+			c->sig[i] = s;
+		}
+		/* Colors are part of the signature, so classes should only split */
+		next = canon_recolor (c);
+		if (next == ncolors)
+			break;
+		ncolors = next;
+	}
+}
+
+static void
+canon_relabel (const struct canon REF(c), char * CDOR_RESTRICT const dest,
+               const char * CDOR_RESTRICT const graph)
+{
+	const size_t n = c->nalt;
+	size_t a, b;
+	for (a = 0; a < n; a++) {
+		for (b = 0; b < n; b++)
+			dest[a * n + b] = graph[c->order[a] * n + c->order[b]] != 0;
+	}
+}
+
+/* Advances order[first..last) to its next permutation, false on wrapping */
+static cdor_bool
+canon_next (size_t * CDOR_RESTRICT const order, const size_t first,
+            const size_t last)
+{
+	size_t pivot = last - 1, i, j, t;
+	while (pivot > first && order[pivot - 1] > order[pivot])
+		pivot--;
+	if (pivot > first) {
+		j = last - 1;
+		while (order[j] < order[pivot - 1])
+			j--;
+		t = order[pivot - 1];
+		order[pivot - 1] = order[j];
+		order[j] = t;
+	}
+	for (i = pivot, j = last - 1; i < j; i++, j--) {
+		t = order[i];
+		order[i] = order[j];
+		order[j] = t;
+	}
+	return pivot > first;
+}
+
+static unsigned long
+canon_count (const struct canon REF(c))
+{
+	unsigned long total = 1;
+	size_t first = 0, k;
+	for (k = 1; k <= c->nalt; k++) {
+		if (k < c->nalt
+		    && c->color[c->order[k]] == c->color[c->order[first]]) {
+			total *= (unsigned long) (k - first + 1);
+			if (total > CACHE_PERMS)
+				return total;
+		} else {
+			first = k;
+		}
+	}
+	return total;
+}
+
+static cdor_bool
+canon_label (struct canon REF(c), const size_t nalt,
+             const char * CDOR_RESTRICT const graph)
+{
+	size_t *best;
+	c->nalt = nalt;
+	c->order = allocate(size_t, 4 * nalt);
+	c->graph = zero_allocate(char, 2 * nalt * nalt);
+	if (!c->order || !c->graph) {
+		free (c->order);
+		free (c->graph);
+		return false;
+	}
+	best = c->order + nalt;
+	c->color = best + nalt;
+	c->sig = c->color + nalt;
+	c->cand = c->graph + nalt * nalt;
+	canon_refine (c, graph);
+	canon_relabel (c, c->graph, graph);
+	if (canon_count (c) <= CACHE_PERMS) {
+		memcpy (best, c->order, nalt * sizeof (size_t));
+		for (;;) {
+			/* Odometer over the orders of every class */
+			size_t first = 0, k;
+			cdor_bool carry = true;
+			for (k = 1; k <= nalt && carry; k++) {
+				if (k < nalt && c->color[c->order[k]]
+				                == c->color[c->order[first]])
+					continue;
+				if (k - first > 1)
+					carry = !canon_next (c->order, first, k);
+				first = k;
+			}
+			if (carry)
+				break;
+			canon_relabel (c, c->cand, graph);
+			if (memcmp (c->cand, c->graph, nalt * nalt) < 0) {
+				memcpy (c->graph, c->cand, nalt * nalt);
+				memcpy (best, c->order, nalt * sizeof (size_t));
+			}
+		}
+		memcpy (c->order, best, nalt * sizeof (size_t));
+	}
+	return true;
+}
+
+static void
+canon_free (struct canon REF(c))
+{
+	free (c->order);
+	free (c->graph);
+}
+
+static size_t
+cache_hash (const size_t nalt, const char * CDOR_RESTRICT const key)
+{
+	size_t h = 2166136261UL ^ nalt, i;
+	for (i = 0; i < nalt * nalt; i++)
+		h = (h ^ (size_t) key[i]) * 16777619UL;
+	return h ^ h >> 15;
+}
+
+static int
+cache_unlabel_compare (const void * const x_arg, const void * const y_arg)
+{
+	const struct cdor_prob * const x = (const struct cdor_prob *) x_arg;
+	const struct cdor_prob * const y = (const struct cdor_prob *) y_arg;
+	return (x->alt > y->alt) - (x->alt < y->alt);
+}
+
+/* Copies a strategy of the canonical graph back to the original labels */
+static struct cdor_strategy
+cache_unlabel (const struct canon REF(c), const struct cdor_strategy s)
+{
+	struct cdor_strategy r = s;
+	size_t k;
+	if (s.type == CDOR_PURE) {
+		r.val.pure = c->order[s.val.pure];
+		return r;
+	}
+	r.val.sparse.supp = allocate(struct cdor_prob, s.val.sparse.len);
+	if (!r.val.sparse.supp) {
+		r.type = CDOR_ERROR;
+		return r;
+	}
+	for (k = 0; k < s.val.sparse.len; k++) {
+		r.val.sparse.supp[k].alt = c->order[s.val.sparse.supp[k].alt];
+		r.val.sparse.supp[k].prob = s.val.sparse.supp[k].prob;
+	}
+	qsort (r.val.sparse.supp, r.val.sparse.len, sizeof (struct cdor_prob),
+	       cache_unlabel_compare);
+	return r;
+}
+
+static void
+cache_lock (struct cdor_strategy_cache REF(cache))
+{
+#ifdef CDOR_THREADS
+	pthread_mutex_lock (&cache->lock);
+#else
+	(void) cache;
+#endif
+}
+
+static void
+cache_unlock (struct cdor_strategy_cache REF(cache))
+{
+#ifdef CDOR_THREADS
+	pthread_mutex_unlock (&cache->lock);
+#else
+	(void) cache;
+#endif
+}
+
+static void
+cache_unlink (struct cdor_strategy_cache REF(cache), const size_t i)
+{
+	struct cache_entry * const e = &cache->entry[i];
+	if (e->prev != NONE)
+		cache->entry[e->prev].next = e->next;
+	else
+		cache->head = e->next;
+	if (e->next != NONE)
+		cache->entry[e->next].prev = e->prev;
+	else
+		cache->tail = e->prev;
+}
+
+static void
+cache_push (struct cdor_strategy_cache REF(cache), const size_t i)
+{
+	struct cache_entry * const e = &cache->entry[i];
+	e->prev = NONE;
+	e->next = cache->head;
+	if (cache->head != NONE)
+		cache->entry[cache->head].prev = i;
+	else
+		cache->tail = i;
+	cache->head = i;
+}
+
+static size_t
+cache_find (const struct cdor_strategy_cache REF(cache), const size_t h,
+            const size_t nalt, const char * CDOR_RESTRICT const key)
+{
+	size_t i = cache->bucket[h & cache->mask];
+	while (i != NONE) {
+		const struct cache_entry * const e = &cache->entry[i];
+		if (e->hash == h && e->nalt == nalt
+		    && memcmp (e->key, key, nalt * nalt) == 0)
+			return i;
+		i = e->chain;
+	}
+	return NONE;
+}
+
+static void
+cache_clear_entry (struct cache_entry REF(e))
+{
+	free (e->key);
+	if (e->strat.type == CDOR_SPARSE)
+		free (e->strat.val.sparse.supp);
+}
+
+/* Removes the least recently used entry and returns its slot */
+static size_t
+cache_evict (struct cdor_strategy_cache REF(cache))
+{
+	const size_t i = cache->tail;
+	struct cache_entry * const e = &cache->entry[i];
+	size_t *link = &cache->bucket[e->hash & cache->mask];
+	while (*link != i)
+		link = &cache->entry[*link].chain;
+	*link = e->chain;
+	cache_unlink (cache, i);
+	cache_clear_entry (e);
+	return i;
+}
+
+/* Takes ownership of key and s, which are freed if they cannot be stored */
+static void
+cache_insert (struct cdor_strategy_cache REF(cache), const size_t h,
+              const size_t nalt, char * CDOR_RESTRICT const key,
+              const struct cdor_strategy s)
+{
+	struct cache_entry *e;
+	size_t i;
+	if (cache_find (cache, h, nalt, key) != NONE) {
+		/* Another thread solved the same graph meanwhile */
+		free (key);
+		if (s.type == CDOR_SPARSE)
+			free (s.val.sparse.supp);
+		return;
+	}
+	i = cache->len < cache->cap ? cache->len++ : cache_evict (cache);
+	e = &cache->entry[i];
+	e->hash = h;
+	e->nalt = nalt;
+	e->key = key;
+	e->strat = s;
+	e->chain = cache->bucket[h & cache->mask];
+	cache->bucket[h & cache->mask] = i;
+	cache_push (cache, i);
+}
+
+struct cdor_strategy_cache *
+cdor_strategy_cache_new (const size_t capacity)
+{
+	struct cdor_strategy_cache *cache;
+	size_t nbuckets = 1, i;
+	if (capacity == 0 || capacity > (size_t) -1 / 2
+	                                / sizeof (struct cache_entry)) {
+		set_errno (EINVAL);
+		return NULL;
+	}
+	while (nbuckets < 2 * capacity)
+		nbuckets *= 2;
+	if (!(cache = allocate(struct cdor_strategy_cache, 1)))
+		return NULL;
+	cache->bucket = allocate(size_t, nbuckets);
+	cache->entry = allocate(struct cache_entry, capacity);
+	if (!cache->bucket || !cache->entry)
+		goto fail;
+#ifdef CDOR_THREADS
+	if (pthread_mutex_init (&cache->lock, NULL) != 0)
+		goto fail;
+#endif
+	for (i = 0; i < nbuckets; i++)
+		cache->bucket[i] = NONE;
+	cache->cap = capacity;
+	cache->len = 0;
+	cache->mask = nbuckets - 1;
+	cache->head = cache->tail = NONE;
+	cache->hits = cache->misses = 0;
+	return cache;
+fail:
+	free (cache->entry);
+	free (cache->bucket);
+	free (cache);
+	return NULL;
+}
+
+struct cdor_strategy
+cdor_cached_strategy (struct cdor_strategy_cache * CDOR_RESTRICT const cache,
+                      const size_t nalt, const char * CDOR_RESTRICT graph)
+{
+	struct cdor_strategy r = { CDOR_ERROR, { 0 } }, s;
+	struct canon c;
+	char *key;
+	size_t h, i;
+	if (nalt == 0 || graph == NULL)
+		return cdor_sparse_strategy (nalt, graph);
+	if (nalt > (size_t) -1 / 4 / nalt / sizeof (size_t)
+	    || !canon_label (&c, nalt, graph))
+		return r;
+	h = cache_hash (nalt, c.graph);
+	cache_lock (cache);
+	i = cache_find (cache, h, nalt, c.graph);
+	if (i != NONE) {
+		cache->hits++;
+		cache_unlink (cache, i);
+		cache_push (cache, i);
+		r = cache_unlabel (&c, cache->entry[i].strat);
+		cache_unlock (cache);
+		canon_free (&c);
+		return r;
+	}
+	cache->misses++;
+	cache_unlock (cache);
+	/* Solve without holding the lock, other lookups may proceed */
+	s = cdor_sparse_strategy (nalt, c.graph);
+	if (s.type == CDOR_ERROR) {
+		canon_free (&c);
+		return s;
+	}
+	r = cache_unlabel (&c, s);
+	if (r.type != CDOR_ERROR && (key = allocate(char, nalt * nalt))) {
+		memcpy (key, c.graph, nalt * nalt);
+		cache_lock (cache);
+		cache_insert (cache, h, nalt, key, s);
+		cache_unlock (cache);
+	} else if (s.type == CDOR_SPARSE) {
+		free (s.val.sparse.supp);
+	}
+	canon_free (&c);
+	return r;
+}
+
+void
+cdor_strategy_cache_stats (struct cdor_strategy_cache * CDOR_RESTRICT cache,
+                           unsigned long * CDOR_RESTRICT const hits,
+                           unsigned long * CDOR_RESTRICT const misses)
+{
+	cache_lock (cache);
+	if (hits)
+		*hits = cache->hits;
+	if (misses)
+		*misses = cache->misses;
+	cache_unlock (cache);
+}
+
+void
+cdor_strategy_cache_free (struct cdor_strategy_cache * const cache)
+{
+	size_t i;
+	if (!cache)
+		return;
+	for (i = 0; i < cache->len; i++)
+		cache_clear_entry (&cache->entry[i]);
+#ifdef CDOR_THREADS
+	pthread_mutex_destroy (&cache->lock);
+#endif
+	free (cache->entry);
+	free (cache->bucket);
+	free (cache);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "condor.h"
+#include "util.h"
+
+/*
+ * Generated by gen_table at build time.  The duel graph among n alternatives
+ * is packed into one base 3 digit per pair i < j, taken row by row: 0 for a
+ * tie, 1 if i beats j and 2 if j beats i.  table_n maps the packed graph to
+ * a strategy number, whose support is table_supp[table_start[k]] up to
+ * table_supp[table_start[k + 1]], a support of one alternative meaning a pure
+ * strategy.
+ */
+#include "strategy_table.h"
+
+/* Largest election covered, 0 if none */
+#if TABLE_MAX >= 2
+const size_t cdor_table_max = TABLE_MAX;
+#else
+const size_t cdor_table_max = 0;
+#endif
+
+cdor_bool
+cdor_table_strategy (const size_t nalt, const char * CDOR_RESTRICT graph,
+                     struct cdor_strategy * CDOR_RESTRICT r)
+{
+#if TABLE_MAX >= 2
+	size_t index = 0, scale = 1, first, len, i, j;
+	if (nalt < 2 || nalt > TABLE_MAX)
+		return false;
+	for (i = 0; i < nalt; i++) {
+		for (j = i + 1; j < nalt; j++, scale *= 3) {
+			const cdor_bool beats = graph[i * nalt + j] != 0;
+			const cdor_bool beaten = graph[j * nalt + i] != 0;
+			/* Not a duel graph, let the solver deal with it */
+			if (beats && beaten)
+				return false;
+			index += scale * (beats ? 1 : beaten ? 2 : 0);
+		}
+	}
+	i = table_by_size[nalt][index];
+	first = table_start[i];
+	len = table_start[i + 1] - first;
+	if (len == 1) {
+		r->type = CDOR_PURE;
+		r->val.pure = table_supp[first].alt;
+	} else if ((r->val.sparse.supp = allocate(struct cdor_prob, len))) {
+		r->type = CDOR_SPARSE;
+		r->val.sparse.len = len;
+		memcpy (r->val.sparse.supp, table_supp + first,
+		        len * sizeof (struct cdor_prob));
+	} else {
+		r->type = CDOR_ERROR;
+	}
+	return true;
+#else
+	(void) nalt;
+	(void) graph;
+	(void) r;
+	return false;
+#endif
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <errno.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "condor.h"
+#include "util.h"
+
+/* Fixed-width types, guessed from the limits before C99 */
+#if __STDC_VERSION__ >= 199901L
+#include <stdint.h>
+typedef uint8_t elem_u8;
+typedef uint16_t elem_u16;
+typedef uint32_t elem_u32;
+typedef int32_t elem_i32;
+typedef uint64_t elem_u64;
+typedef int64_t elem_i64;
+#define HAVE_ELEM_64 1
+#else
+typedef unsigned char elem_u8;
+typedef unsigned short elem_u16;
+#if UINT_MAX == 0xffffffff
+typedef unsigned int elem_u32;
+typedef int elem_i32;
+#else
+typedef unsigned long elem_u32;
+typedef long elem_i32;
+#endif
+#if ULONG_MAX > 0xffffffff
+typedef unsigned long elem_u64;
+typedef long elem_i64;
+#define HAVE_ELEM_64 1
+#endif
+#endif
+
+/*
+ * Elements are read with memcpy since strided buffers need not be aligned,
+ * which compilers turn into plain loads where alignment does not matter.  Pairs
+ * are visited by tiles as in cdor_make_duel_graph, since one of the strides is
+ * large whatever the layout.
+ */
+#define STRIDED_TILE 16
+
+#define STRIDED_GRAPH(name, T) \
+static void \
+name (const size_t nalt, char * CDOR_RESTRICT graph, \
+      const char * CDOR_RESTRICT duels, const ptrdiff_t row, \
+      const ptrdiff_t col) \
+{ \
+	size_t ti, tj, i, j; \
+	for (ti = 0; ti < nalt; ti += STRIDED_TILE) { \
+		const size_t ei = nalt - ti < STRIDED_TILE ? nalt \
+		                  : ti + STRIDED_TILE; \
+		for (tj = ti; tj < nalt; tj += STRIDED_TILE) { \
+			const size_t ej = nalt - tj < STRIDED_TILE ? nalt \
+			                  : tj + STRIDED_TILE; \
+			for (i = ti; i < ei; i++) { \
+				const char * const ri = duels + (ptrdiff_t) i * row; \
+				const char * const ci = duels + (ptrdiff_t) i * col; \
+				graph[i * nalt + i] = 0; \
+				for (j = tj == ti ? i + 1 : tj; j < ej; j++) { \
+					T l, r; \
+					memcpy (&l, ri + (ptrdiff_t) j * col, sizeof (T)); \
+					memcpy (&r, ci + (ptrdiff_t) j * row, sizeof (T)); \
+					graph[i * nalt + j] = l > r; \
+					graph[j * nalt + i] = r > l; \
+				} \
+			} \
+		} \
+	} \
+}
+
+STRIDED_GRAPH(strided_u8, elem_u8)
+STRIDED_GRAPH(strided_u16, elem_u16)
+STRIDED_GRAPH(strided_u32, elem_u32)
+STRIDED_GRAPH(strided_i32, elem_i32)
+#ifdef HAVE_ELEM_64
+STRIDED_GRAPH(strided_u64, elem_u64)
+STRIDED_GRAPH(strided_i64, elem_i64)
+#endif
+STRIDED_GRAPH(strided_f64, double)
+
+int
+cdor_make_strided_graph (const size_t nalt, char * CDOR_RESTRICT graph,
+                         const void * CDOR_RESTRICT duels,
+                         const struct cdor_layout * CDOR_RESTRICT layout)
+{
+	void (*make) (size_t, char *, const char *, ptrdiff_t, ptrdiff_t);
+	switch (layout->type) {
+	case CDOR_U8:
+		make = strided_u8;
+		break;
+	case CDOR_U16:
+		make = strided_u16;
+		break;
+	case CDOR_U32:
+		make = strided_u32;
+		break;
+	case CDOR_I32:
+		make = strided_i32;
+		break;
+#ifdef HAVE_ELEM_64
+	case CDOR_U64:
+		make = strided_u64;
+		break;
+	case CDOR_I64:
+		make = strided_i64;
+		break;
+#endif
+	case CDOR_F64:
+		make = strided_f64;
+		break;
+	default:
+		set_errno (EINVAL);
+		return -1;
+	}
+	make (nalt, graph, (const char *) duels, layout->row, layout->col);
+	return 0;
+}
+
+struct cdor_strategy
+cdor_strided_strategy (const size_t nalt, const void * CDOR_RESTRICT duels,
+                       const struct cdor_layout * CDOR_RESTRICT layout)
+{
+	struct cdor_strategy r = { CDOR_ERROR, { 0 } };
+	char *graph;
+	if (nalt == 0 || nalt > (size_t) -1 / nalt) {
+		set_errno (EINVAL);
+		return r;
+	}
+	if (!(graph = allocate(char, nalt * nalt)))
+		return r;
+	if (cdor_make_strided_graph (nalt, graph, duels, layout) == 0)
+		r = cdor_sparse_strategy (nalt, graph);
+	free (graph);
+	return r;
+}
@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "condor.h"
+#include "util.h"
+
+/*
+ * Alongside the advantage graph, a tally counts for each alternative how many
+ * others beat it.  Casts update the counts of the pairs they touch, and the
+ * undefeated alternatives, the sources of the duel graph, are counted and
+ * their numbers summed, so that a lone source can be named without searching.
+ */
+struct cdor_tally {
+	size_t nalt;
+	cdor_adv *duels;
+	size_t *beaten;
+	/* Alternatives listed by the partial ranking being cast */
+	cdor_bool *listed;
+	size_t nsources;
+	size_t source_sum;
+};
+
+static void
+tally_lose (struct cdor_tally REF(t), const size_t i)
+{
+	if (t->beaten[i]++ == 0) {
+		t->nsources--;
+		t->source_sum -= i;
+	}
+}
+
+static void
+tally_unlose (struct cdor_tally REF(t), const size_t i)
+{
+	if (--t->beaten[i] == 0) {
+		t->nsources++;
+		t->source_sum += i;
+	}
+}
+
+/* Sets the counters of the duel between i and j */
+static void
+tally_set (struct cdor_tally REF(t), const size_t i, const size_t j,
+           const cdor_adv ij, const cdor_adv ji)
+{
+	cdor_adv * const pij = t->duels + i * t->nalt + j;
+	cdor_adv * const pji = t->duels + j * t->nalt + i;
+	const int before = (*pij > *pji) - (*pji > *pij);
+	const int after = (ij > ji) - (ji > ij);
+	*pij = ij;
+	*pji = ji;
+	if (before == after)
+		return;
+	if (before > 0)
+		tally_unlose (t, j);
+	else if (before < 0)
+		tally_unlose (t, i);
+	if (after > 0)
+		tally_lose (t, j);
+	else if (after < 0)
+		tally_lose (t, i);
+}
+
+/* Adds weight electors preferring i over j */
+static void
+tally_add (struct cdor_tally REF(t), const size_t i, const size_t j,
+           const cdor_adv weight)
+{
+	tally_set (t, i, j, t->duels[i * t->nalt + j] + weight,
+	           t->duels[j * t->nalt + i]);
+}
+
+struct cdor_tally *
+cdor_tally_new (const size_t nalt, const cdor_adv * CDOR_RESTRICT duels)
+{
+	struct cdor_tally *t;
+	size_t i, j;
+	if (nalt == 0 || nalt > (size_t) -1 / sizeof (cdor_adv) / nalt) {
+		set_errno (EINVAL);
+		return NULL;
+	}
+	if (!(t = allocate(struct cdor_tally, 1)))
+		return NULL;
+	t->nalt = nalt;
+	t->duels = duels ? allocate(cdor_adv, nalt * nalt)
+	           : zero_allocate(cdor_adv, nalt * nalt);
+	t->beaten = zero_allocate(size_t, nalt);
+	t->listed = zero_allocate(cdor_bool, nalt);
+	if (!t->duels || !t->beaten || !t->listed) {
+		cdor_tally_free (t);
+		return NULL;
+	}
+	t->nsources = nalt;
+	t->source_sum = 0;
+	for (i = 0; i < nalt; i++)
+		t->source_sum += i;
+	if (duels) {
+		memcpy (t->duels, duels, nalt * nalt * sizeof (cdor_adv));
+		for (i = 0; i < nalt; i++) {
+			for (j = 0; j < nalt; j++) {
+				if (duels[j * nalt + i] > duels[i * nalt + j])
+					tally_lose (t, i);
+			}
+		}
+	}
+	return t;
+}
+
+void
+cdor_tally_free (struct cdor_tally * const t)
+{
+	if (!t)
+		return;
+	free (t->listed);
+	free (t->beaten);
+	free (t->duels);
+	free (t);
+}
+
+void
+cdor_tally_ranking (struct cdor_tally * CDOR_RESTRICT const t,
+                    const size_t * CDOR_RESTRICT rank, const cdor_adv weight)
+{
+	const size_t nalt = t->nalt;
+	size_t i, j, worst = 0;
+	if (weight == 0)
+		return;
+	for (i = 0; i < nalt; i++) {
+		if (rank[i] > worst)
+			worst = rank[i];
+	}
+	/* As in cdor_cast_weighted_ranking, the last ones beat nobody */
+	for (i = 0; i < nalt; i++) {
+		if (rank[i] == worst)
+			continue;
+		for (j = 0; j < nalt; j++) {
+			if (rank[i] < rank[j])
+				tally_add (t, i, j, weight);
+		}
+	}
+}
+
+void
+cdor_tally_partial_ranking (struct cdor_tally * CDOR_RESTRICT const t,
+                            const size_t len,
+                            const size_t * CDOR_RESTRICT alt,
+                            const size_t * CDOR_RESTRICT rank,
+                            const cdor_adv weight)
+{
+	size_t a, b, j;
+	if (weight == 0)
+		return;
+	for (a = 0; a < len; a++)
+		t->listed[alt[a]] = true;
+	for (a = 0; a < len; a++) {
+		/* Every alternative left out is beaten */
+		for (j = 0; j < t->nalt; j++) {
+			if (!t->listed[j])
+				tally_add (t, alt[a], j, weight);
+		}
+		for (b = 0; b < len; b++) {
+			if (rank[a] < rank[b])
+				tally_add (t, alt[a], alt[b], weight);
+		}
+	}
+	for (a = 0; a < len; a++)
+		t->listed[alt[a]] = false;
+}
+
+const cdor_adv *
+cdor_tally_duels (const struct cdor_tally * const t)
+{
+	return t->duels;
+}
+
+size_t
+cdor_tally_sources (const struct cdor_tally * CDOR_RESTRICT const t,
+                    size_t * CDOR_RESTRICT const winner)
+{
+	if (t->nsources == 1 && winner)
+		*winner = t->source_sum;
+	return t->nsources;
+}
+
+struct cdor_strategy
+cdor_tally_strategy (const struct cdor_tally * const t)
+{
+	struct cdor_strategy r = { CDOR_PURE, { 0 } };
+	if (t->nsources != 1)
+		return cdor_duels_strategy (t->nalt, t->duels);
+	r.val.pure = t->source_sum;
+	return r;
+}
+
+/*
+ * Adds or subtracts other, checking every counter first like duel_arith.c.
+ * The diagonal is ignored, since the tally only counts duels.
+ */
+static int
+tally_combine (struct cdor_tally * CDOR_RESTRICT const t,
+               const cdor_adv * CDOR_RESTRICT const other,
+               const cdor_bool subtract)
+{
+	const size_t nalt = t->nalt;
+	cdor_adv ovf = 0;
+	size_t i, j;
+	for (i = 0; i < nalt; i++) {
+		for (j = 0; j < nalt; j++) {
+			const size_t k = i * nalt + j;
+			if (i == j)
+				continue;
+			ovf |= (cdor_adv) (subtract ? t->duels[k] < other[k]
+			                   : t->duels[k] + other[k] < other[k]);
+		}
+	}
+	if (ovf) {
+		set_errno (ERANGE);
+		return -1;
+	}
+	for (i = 0; i < nalt; i++) {
+		for (j = i + 1; j < nalt; j++) {
+			const cdor_adv ij = other[i * nalt + j];
+			const cdor_adv ji = other[j * nalt + i];
+			if (subtract)
+				tally_set (t, i, j, t->duels[i * nalt + j] - ij,
+				           t->duels[j * nalt + i] - ji);
+			else
+				tally_set (t, i, j, t->duels[i * nalt + j] + ij,
+				           t->duels[j * nalt + i] + ji);
+		}
+	}
+	return 0;
+}
+
+int
+cdor_tally_add_duels (struct cdor_tally * CDOR_RESTRICT const t,
+                      const cdor_adv * CDOR_RESTRICT const other)
+{
+	return tally_combine (t, other, false);
+}
+
+int
+cdor_tally_subtract_duels (struct cdor_tally * CDOR_RESTRICT const t,
+                           const cdor_adv * CDOR_RESTRICT const other)
+{
+	return tally_combine (t, other, true);
+}
@@ -14,13 +14,30 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
  */
+#include <errno.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "condor.h"
 #include "util.h"
 
+#ifdef CDOR_THREADS
+#include <pthread.h>
+#endif
+
+#if _POSIX_C_SOURCE >= 200112L
+#include <signal.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+
+#include "condord.h"
+#endif
+
 static cdor_bool
 test_empty (void)
 {
@@ -33,6 +50,10 @@ test_empty (void)
 	case CDOR_PURE:
 		puts ("a strategy was found");
 		return false;
+	case CDOR_SPARSE:
+		free (strat.val.sparse.supp);
+		puts ("a strategy was found");
+		return false;
 	case CDOR_ERROR:
 		puts ("OK");
 	}
@@ -132,6 +153,43 @@ expect_mixed (const struct cdor_strategy REF(strat), const size_t nalt,
 	return true;
 }
 
+static cdor_bool
+expect_sparse (const struct cdor_strategy REF(strat), const size_t nalt,
+               const double ARR_PARAM(expect, nalt))
+{
+	double * const dense = zero_allocate(double, nalt);
+	size_t i, len = 0;
+	cdor_bool ok;
+	if (strat->type != CDOR_SPARSE) {
+		if (strat->type == CDOR_MIXED)
+			free (strat->val.mixed);
+		puts ("strategy was not sparse");
+		free (dense);
+		return false;
+	}
+	if (!dense) {
+		free (strat->val.sparse.supp);
+		puts ("out of memory");
+		return false;
+	}
+	ok = true;
+	for (i = 0; i < strat->val.sparse.len; i++) {
+		const struct cdor_prob p = strat->val.sparse.supp[i];
+		if (p.alt >= nalt || (i > 0 && p.alt <= strat->val.sparse.supp[i - 1].alt))
+			ok = false;
+		else
+			dense[p.alt] = p.prob;
+	}
+	for (i = 0; i < nalt; i++)
+		len += expect[i] > 0.0;
+	ok = ok && len == strat->val.sparse.len
+	     && vec_compare (nalt, dense, expect);
+	free (strat->val.sparse.supp);
+	free (dense);
+	puts (ok ? "OK" : "support does not match");
+	return ok;
+}
+
 static cdor_bool
 test_tie (void)
 {
@@ -338,6 +396,1186 @@ test_paradox_plus_5 (void)
 	return expect_mixed (&strat, 8, expected);
 }
 
+static cdor_bool
+test_sparse_sources (void)
+{
+	const char graph[9] = { 0, 1, 0, 0, 0, 0, 0, 0, 0 };
+	const struct cdor_strategy strat = cdor_sparse_strategy (3, graph);
+	const double expected[3] = { 0.5, 0.0, 0.5 };
+	fputs ("test_sparse_sources: ", stdout);
+	return expect_sparse (&strat, 3, expected);
+}
+
+static cdor_bool
+test_sparse_paradox_plus_5 (void)
+{
+	const char graph[64] = {
+		0, 1, 0, 0, 0, 0, 0, 0,
+		0, 0, 1, 0, 0, 0, 0, 0,
+		1, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 1, 1, 1, 0,
+		0, 0, 0, 0, 0, 1, 0, 1,
+		0, 0, 0, 0, 0, 0, 1, 1,
+		0, 0, 0, 0, 1, 0, 0, 1,
+		0, 0, 0, 1, 0, 0, 0, 0
+	};
+	const struct cdor_strategy strat = cdor_sparse_strategy (8, graph);
+	const double expected[8] = {
+		1.0 / 6.0,
+		1.0 / 6.0,
+		1.0 / 6.0,
+		1.0 / 6.0,
+		1.0 / 18.0,
+		1.0 / 18.0,
+		1.0 / 18.0,
+		1.0 / 6.0
+	};
+	fputs ("test_sparse_paradox_plus_5: ", stdout);
+	return expect_sparse (&strat, 8, expected);
+}
+
+static cdor_bool
+test_small_ties (void)
+{
+	/* Cycle among the first three, the last one ties with everyone */
+	const char graph[16] = {
+		0, 0, 1, 0,
+		1, 0, 0, 0,
+		0, 1, 0, 0,
+		0, 0, 0, 0
+	};
+	const struct cdor_strategy strat = cdor_sparse_strategy (4, graph);
+	fputs ("test_small_ties: ", stdout);
+	if (strat.type == CDOR_SPARSE)
+		free (strat.val.sparse.supp);
+	if (strat.type != CDOR_PURE || strat.val.pure != 3) {
+		puts ("unbeaten alternative should win");
+		return false;
+	}
+	puts ("OK");
+	return true;
+}
+
+static cdor_bool
+test_approx_strategy (void)
+{
+	const char graph[64] = {
+		0, 1, 0, 0, 0, 0, 0, 0,
+		0, 0, 1, 0, 0, 0, 0, 0,
+		1, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 1, 1, 1, 0,
+		0, 0, 0, 0, 0, 1, 0, 1,
+		0, 0, 0, 0, 0, 0, 1, 1,
+		0, 0, 0, 0, 1, 0, 0, 1,
+		0, 0, 0, 1, 0, 0, 0, 0
+	};
+	double gap = -1.0;
+	const struct cdor_strategy strat = cdor_approx_strategy (8, graph, 1e-3,
+	                                                         1000000, 0.0,
+	                                                         &gap);
+	size_t i;
+	cdor_bool ok;
+	fputs ("test_approx_strategy: ", stdout);
+	if (strat.type != CDOR_MIXED) {
+		if (strat.type == CDOR_SPARSE)
+			free (strat.val.sparse.supp);
+		puts ("strategy was not mixed");
+		return false;
+	}
+	/* Nobody can gain more than the gap against the strategy */
+	ok = gap >= 0.0 && gap <= 1e-3;
+	for (i = 0; i < 8; i++) {
+		size_t j;
+		double payoff = 0.0;
+		for (j = 0; j < 8; j++) {
+			if (graph[i * 8 + j])
+				payoff += strat.val.mixed[j];
+			else if (graph[j * 8 + i])
+				payoff -= strat.val.mixed[j];
+		}
+		ok = ok && payoff <= gap + 1e-12;
+	}
+	free (strat.val.mixed);
+	puts (ok ? "OK" : "gap is wrong");
+	return ok;
+}
+
+static cdor_bool
+test_check_strategy (void)
+{
+	char graph[9] = { 0, 1, 0, 0, 0, 1, 1, 0, 0 };
+	const struct cdor_prob third[3] = {
+		{ 0, 1.0 / 3.0 },
+		{ 1, 1.0 / 3.0 },
+		{ 2, 1.0 / 3.0 }
+	};
+	double mixed[3] = { 1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0 };
+	struct cdor_strategy strat;
+	double gap = -1.0;
+	cdor_bool ok;
+	fputs ("test_check_strategy: ", stdout);
+	strat.type = CDOR_SPARSE;
+	strat.val.sparse.len = 3;
+	strat.val.sparse.supp = (struct cdor_prob *) third;
+	ok = cdor_check_strategy (3, graph, &strat, 1e-12, &gap) == 1
+	     && gap < 1e-12;
+	/* Alternative 0 now beats 2 as well, so playing 0 gains 2/3 */
+	graph[2] = 1;
+	graph[6] = 0;
+	ok = ok && cdor_check_strategy (3, graph, &strat, 1e-12, &gap) == 0
+	     && gap > 0.66 && gap < 0.67;
+	strat.type = CDOR_PURE;
+	strat.val.pure = 0;
+	ok = ok && cdor_check_strategy (3, graph, &strat, 0.0, &gap) == 1
+	     && gap == 0.0;
+	strat.val.pure = 3;
+	ok = ok && cdor_check_strategy (3, graph, &strat, 0.0, &gap) < 0;
+	/* The same through the dense path */
+	strat.type = CDOR_MIXED;
+	strat.val.mixed = mixed;
+	ok = ok && cdor_check_strategy (3, graph, &strat, 1e-12, &gap) == 0
+	     && gap > 0.66 && gap < 0.67;
+	graph[2] = 0;
+	graph[6] = 1;
+	ok = ok && cdor_check_strategy (3, graph, &strat, 1e-12, &gap) == 1
+	     && gap < 1e-12;
+	/* Not distributions, however good their gap looks */
+	mixed[0] = mixed[1] = mixed[2] = 0.0;
+	errno = 0;
+	ok = ok && cdor_check_strategy (3, graph, &strat, 1e-12, &gap) < 0;
+#if _POSIX_C_SOURCE >= 1L
+	ok = ok && errno == EINVAL;
+#endif
+	mixed[0] = 1.5;
+	mixed[1] = -0.5;
+	ok = ok && cdor_check_strategy (3, graph, &strat, 1e-12, &gap) < 0;
+	strat.type = CDOR_SPARSE;
+	strat.val.sparse.len = 2;
+	ok = ok && cdor_check_strategy (3, graph, &strat, 1e-12, &gap) < 0;
+	puts (ok ? "OK" : "wrong verdict");
+	return ok;
+}
+
+static cdor_bool
+test_strided_graph (void)
+{
+	const cdor_adv duels[9] = { 0, 5, 2, 1, 0, 7, 4, 0, 0 };
+	/* Transposed, and embedded in a wider matrix of another type */
+	unsigned short columns[9];
+	double wide[20];
+	struct cdor_layout layout;
+	char expect[9], graph[9];
+	size_t i, j;
+	cdor_bool ok;
+	fputs ("test_strided_graph: ", stdout);
+	for (i = 0; i < 20; i++)
+		wide[i] = -1.0;
+	for (i = 0; i < 3; i++) {
+		for (j = 0; j < 3; j++) {
+			columns[j * 3 + i] = (unsigned short) duels[i * 3 + j];
+			wide[(i + 1) * 5 + j + 1] = (double) duels[i * 3 + j];
+		}
+	}
+	cdor_make_duel_graph (3, expect, duels);
+	layout.type = CDOR_U16;
+	layout.row = sizeof (unsigned short);
+	layout.col = 3 * sizeof (unsigned short);
+	ok = cdor_make_strided_graph (3, graph, columns, &layout) == 0
+	     && memcmp (graph, expect, 9) == 0;
+	layout.type = CDOR_F64;
+	layout.row = 5 * sizeof (double);
+	layout.col = sizeof (double);
+	memset (graph, 2, 9);
+	ok = ok && cdor_make_strided_graph (3, graph, wide + 6, &layout) == 0
+	     && memcmp (graph, expect, 9) == 0;
+	puts (ok ? "OK" : "strided graph differs");
+	return ok;
+}
+
+/* Spans several tiles with partial ones at the edges */
+static cdor_bool
+test_tiled_graph (void)
+{
+	enum { N = 37 };
+	cdor_adv duels[N * N];
+	unsigned char wide[N * N];
+	struct cdor_layout layout;
+	char graph[N * N], strided[N * N];
+	size_t i, j;
+	cdor_bool ok = true;
+	fputs ("test_tiled_graph: ", stdout);
+	for (i = 0; i < N * N; i++) {
+		duels[i] = (cdor_adv) (i * 7919 % 5);
+		wide[i] = (unsigned char) duels[i];
+	}
+	memset (graph, 2, sizeof graph);
+	memset (strided, 2, sizeof strided);
+	cdor_make_duel_graph (N, graph, duels);
+	layout.type = CDOR_U8;
+	layout.row = N;
+	layout.col = 1;
+	ok = cdor_make_strided_graph (N, strided, wide, &layout) == 0;
+	for (i = 0; i < N; i++) {
+		for (j = 0; j < N; j++) {
+			const char expect = i != j
+			                    && duels[i * N + j] > duels[j * N + i];
+			ok = ok && graph[i * N + j] == expect
+			     && strided[i * N + j] == expect;
+		}
+	}
+	puts (ok ? "OK" : "tiled graph differs");
+	return ok;
+}
+
+/* Whether both paths agree on the advantage graph, freeing the strategies */
+static cdor_bool
+duels_agree (const size_t nalt, const cdor_adv * const duels)
+{
+	char graph[12 * 12];
+	struct cdor_strategy a, b;
+	cdor_bool same;
+	cdor_make_duel_graph (nalt, graph, duels);
+	a = cdor_duels_strategy (nalt, duels);
+	b = cdor_sparse_strategy (nalt, graph);
+	same = a.type == b.type;
+	if (same && a.type == CDOR_PURE)
+		same = a.val.pure == b.val.pure;
+	else if (same && a.type == CDOR_SPARSE)
+		same = a.val.sparse.len == b.val.sparse.len
+		       && memcmp (a.val.sparse.supp, b.val.sparse.supp,
+		                  a.val.sparse.len * sizeof (struct cdor_prob)) == 0;
+	if (a.type == CDOR_SPARSE)
+		free (a.val.sparse.supp);
+	if (b.type == CDOR_SPARSE)
+		free (b.val.sparse.supp);
+	return same && a.type != CDOR_ERROR;
+}
+
+static cdor_bool
+test_duels_strategy (void)
+{
+	enum { N = 12 };
+	cdor_adv duels[N * N];
+	size_t i, j;
+	cdor_bool ok;
+	fputs ("test_duels_strategy: ", stdout);
+	for (i = 0; i < N * N; i++)
+		duels[i] = (cdor_adv) (i * 7919 % 5);
+	ok = duels_agree (N, duels);
+	/* Two cycles, {0, 1, 2} and the rest, with no duel between them */
+	memset (duels, 0, sizeof duels);
+	for (i = 0; i < 3; i++)
+		duels[i * N + (i + 1) % 3] = 1;
+	for (i = 3; i < N; i++)
+		duels[i * N + (i - 2) % (N - 3) + 3] = 2;
+	ok = ok && duels_agree (N, duels);
+	/* Alternative 5 beats everyone */
+	for (j = 0; j < N; j++)
+		duels[5 * N + j] = j != 5 ? 3 : 0;
+	ok = ok && duels_agree (N, duels);
+	/* Below the size where the duel graph is built anyway */
+	ok = ok && duels_agree (4, duels);
+	puts (ok ? "OK" : "strategies from duels differ");
+	return ok;
+}
+
+static cdor_bool
+test_presolve (void)
+{
+	/*
+	 * Cycle among the first three, the fourth one is a clone of the first,
+	 * and the last five form a chain losing to all of them.
+	 */
+	const char graph[81] = {
+		0, 1, 0, 0, 1, 1, 1, 1, 1,
+		0, 0, 1, 0, 1, 1, 1, 1, 1,
+		1, 0, 0, 1, 1, 1, 1, 1, 1,
+		0, 1, 0, 0, 1, 1, 1, 1, 1,
+		0, 0, 0, 0, 0, 1, 1, 1, 1,
+		0, 0, 0, 0, 0, 0, 1, 1, 1,
+		0, 0, 0, 0, 0, 0, 0, 1, 1,
+		0, 0, 0, 0, 0, 0, 0, 0, 1,
+		0, 0, 0, 0, 0, 0, 0, 0, 0
+	};
+	const double expected[9] = {
+		1.0 / 6.0,
+		1.0 / 3.0,
+		1.0 / 3.0,
+		1.0 / 6.0,
+		0.0,
+		0.0,
+		0.0,
+		0.0,
+		0.0
+	};
+	const struct cdor_strategy strat = cdor_sparse_strategy (9, graph);
+	fputs ("test_presolve: ", stdout);
+	return expect_sparse (&strat, 9, expected);
+}
+
+static cdor_bool
+test_strategy_cache (void)
+{
+	const char graph[64] = {
+		0, 1, 0, 0, 0, 0, 0, 0,
+		0, 0, 1, 0, 0, 0, 0, 0,
+		1, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 1, 1, 1, 0,
+		0, 0, 0, 0, 0, 1, 0, 1,
+		0, 0, 0, 0, 0, 0, 1, 1,
+		0, 0, 0, 0, 1, 0, 0, 1,
+		0, 0, 0, 1, 0, 0, 0, 0
+	};
+	/* Same as test_sparse_paradox_plus_5 with labels reversed */
+	const double expected[8] = {
+		1.0 / 6.0,
+		1.0 / 18.0,
+		1.0 / 18.0,
+		1.0 / 18.0,
+		1.0 / 6.0,
+		1.0 / 6.0,
+		1.0 / 6.0,
+		1.0 / 6.0
+	};
+	struct cdor_strategy_cache * const cache = cdor_strategy_cache_new (1);
+	struct cdor_strategy strat;
+	char relabeled[64];
+	unsigned long hits, misses;
+	size_t i, j;
+	fputs ("test_strategy_cache: ", stdout);
+	if (!cache) {
+		puts ("could not create cache");
+		return false;
+	}
+	for (i = 0; i < 8; i++) {
+		for (j = 0; j < 8; j++)
+			relabeled[(7 - i) * 8 + 7 - j] = graph[i * 8 + j];
+	}
+	strat = cdor_cached_strategy (cache, 8, graph);
+	if (strat.type == CDOR_SPARSE)
+		free (strat.val.sparse.supp);
+	strat = cdor_cached_strategy (cache, 8, relabeled);
+	cdor_strategy_cache_stats (cache, &hits, &misses);
+	cdor_strategy_cache_free (cache);
+	if (hits != 1 || misses != 1) {
+		if (strat.type == CDOR_SPARSE)
+			free (strat.val.sparse.supp);
+		puts ("relabeled graph missed the cache");
+		return false;
+	}
+	return expect_sparse (&strat, 8, expected);
+}
+
+static cdor_bool
+test_snapshot_roundtrip (void)
+{
+	const cdor_adv duels[9] = { 0, 5, 2, 1, 0, 7, 4, 0, 0 };
+	FILE * const f = tmpfile ();
+	cdor_adv *loaded = NULL;
+	size_t nalt = 0;
+	cdor_bool ok;
+	fputs ("test_snapshot_roundtrip: ", stdout);
+	if (!f) {
+		puts ("could not open temporary file");
+		return false;
+	}
+	ok = cdor_save_duels (f, 3, duels) == 0;
+	rewind (f);
+	ok = ok && (loaded = cdor_load_duels (f, &nalt)) != NULL && nalt == 3
+	     && memcmp (loaded, duels, sizeof duels) == 0;
+#if _POSIX_C_SOURCE >= 200112L
+	if (ok) {
+		const cdor_adv * const mapped = cdor_map_duels (fileno (f), &nalt);
+		ok = mapped && nalt == 3 && memcmp (mapped, duels, sizeof duels) == 0;
+		if (mapped)
+			cdor_unmap_duels (nalt, mapped);
+	}
+#endif
+	free (loaded);
+	fclose (f);
+	puts (ok ? "OK" : "snapshot does not match");
+	return ok;
+}
+
+static cdor_bool
+test_snapshot_delta (void)
+{
+	const cdor_adv part[4] = { 0, 3, 0, 0 };
+	cdor_adv duels[4] = { 0, 1, 2, 0 };
+	const cdor_adv expected[4] = { 0, 4, 2, 0 };
+	FILE * const f = tmpfile ();
+	cdor_bool ok;
+	fputs ("test_snapshot_delta: ", stdout);
+	if (!f) {
+		puts ("could not open temporary file");
+		return false;
+	}
+	ok = cdor_save_delta (f, 2, part) == 0;
+	rewind (f);
+	ok = ok && cdor_merge_duels (f, 2, duels) == 0
+	     && memcmp (duels, expected, sizeof duels) == 0;
+	rewind (f);
+	ok = ok && cdor_merge_duels (f, 3, duels) != 0;
+	fclose (f);
+	puts (ok ? "OK" : "delta was not merged correctly");
+	return ok;
+}
+
+static cdor_bool
+ingest_string (const char * const text, const size_t nalt,
+               cdor_adv * const duels, size_t * const count)
+{
+	FILE * const f = tmpfile ();
+	int res;
+	if (!f)
+		return false;
+	fputs (text, f);
+	rewind (f);
+	res = cdor_ingest_ballots (f, nalt, duels, count);
+	fclose (f);
+	return res == 0;
+}
+
+static cdor_bool
+test_ingest (void)
+{
+	const char text[] = "0>1=2\n# comment\n2 > 0\n\n1\n0=1>2";
+	const cdor_adv expected[9] = { 0, 2, 2, 1, 0, 2, 1, 1, 0 };
+	cdor_adv duels[9] = { 0 };
+	size_t count = 0;
+	cdor_bool ok;
+	fputs ("test_ingest: ", stdout);
+	ok = ingest_string (text, 3, duels, &count) && count == 4
+	     && memcmp (duels, expected, sizeof duels) == 0;
+	ok = ok && !ingest_string ("0>1\n0>>1\n", 3, duels, &count)
+	     && count == 1;
+	puts (ok ? "OK" : "ballots were not ingested correctly");
+	return ok;
+}
+
+static cdor_bool
+test_ballot_set (void)
+{
+	const size_t a[3] = { 0, 1, 1 }, b[3] = { 2, 0, 1 };
+	cdor_adv duels[9] = { 0 }, expected[9] = { 0 };
+	struct cdor_ballot_set * const set = cdor_ballot_set_new (3);
+	size_t i;
+	cdor_bool ok = set != NULL;
+	fputs ("test_ballot_set: ", stdout);
+	for (i = 0; ok && i < 100; i++)
+		ok = cdor_ballot_set_add (set, i % 3 ? a : b, 2) == 0;
+	ok = ok && cdor_ballot_set_size (set) == 2;
+	if (ok)
+		cdor_ballot_set_flush (set, duels);
+	cdor_ballot_set_free (set);
+	cdor_cast_weighted_ranking (3, expected, a, 132);
+	cdor_cast_weighted_ranking (3, expected, b, 68);
+	ok = ok && memcmp (duels, expected, sizeof duels) == 0;
+	puts (ok ? "OK" : "ballots were not aggregated correctly");
+	return ok;
+}
+
+static cdor_bool
+test_partial_ranking (void)
+{
+	/* 4 > 1 = 5, the three others tied below */
+	const size_t alt[3] = { 4, 1, 5 }, rank[3] = { 0, 1, 1 };
+	const size_t full[6] = { 2, 1, 2, 2, 0, 1 };
+	cdor_adv duels[36] = { 0 }, expected[36] = { 0 };
+	size_t i, j;
+	cdor_bool ok = true;
+	fputs ("test_partial_ranking: ", stdout);
+	cdor_cast_partial_ranking (6, duels, 3, alt, rank, 3);
+	for (i = 0; i < 6; i++) {
+		for (j = 0; j < 6; j++)
+			expected[i * 6 + j] = full[i] < full[j] ? 3 : 0;
+	}
+	ok = memcmp (duels, expected, sizeof duels) == 0;
+	memset (duels, 0, sizeof duels);
+	cdor_cast_weighted_ranking (6, duels, full, 3);
+	ok = ok && memcmp (duels, expected, sizeof duels) == 0;
+	puts (ok ? "OK" : "partial ranking was not cast correctly");
+	return ok;
+}
+
+static cdor_bool
+test_tally (void)
+{
+	/* A > B > C, then B > C > A and C > A > B, the last one truncated */
+	const size_t abc[3] = { 0, 1, 2 }, bca[3] = { 2, 0, 1 };
+	const size_t alt[2] = { 2, 0 }, rank[2] = { 0, 1 };
+	cdor_adv expected[9] = { 0 };
+	struct cdor_tally *t = cdor_tally_new (3, NULL), *copy;
+	struct cdor_strategy s;
+	size_t winner = 3;
+	cdor_bool ok;
+	fputs ("test_tally: ", stdout);
+	if (!t) {
+		puts ("could not allocate a tally");
+		return false;
+	}
+	ok = cdor_tally_sources (t, NULL) == 3;
+	cdor_tally_ranking (t, abc, 1);
+	s = cdor_tally_strategy (t);
+	ok = ok && cdor_tally_sources (t, &winner) == 1 && winner == 0
+	     && s.type == CDOR_PURE && s.val.pure == 0;
+	cdor_tally_ranking (t, bca, 1);
+	cdor_tally_partial_ranking (t, 2, alt, rank, 1);
+	cdor_cast_weighted_ranking (3, expected, abc, 1);
+	cdor_cast_weighted_ranking (3, expected, bca, 1);
+	cdor_cast_partial_ranking (3, expected, 2, alt, rank, 1);
+	ok = ok && memcmp (cdor_tally_duels (t), expected, sizeof expected) == 0
+	     && cdor_tally_sources (t, NULL) == 0;
+	s = cdor_tally_strategy (t);
+	if (s.type == CDOR_MIXED)
+		free (s.val.mixed);
+	else if (s.type == CDOR_SPARSE)
+		free (s.val.sparse.supp);
+	ok = ok && (s.type == CDOR_MIXED || s.type == CDOR_SPARSE);
+	/* Adding a ballot breaks the cycle */
+	cdor_tally_ranking (t, bca, 1);
+	ok = ok && cdor_tally_sources (t, &winner) == 1 && winner == 1;
+	if ((copy = cdor_tally_new (3, cdor_tally_duels (t)))) {
+		ok = ok && cdor_tally_sources (copy, &winner) == 1 && winner == 1;
+		cdor_tally_free (copy);
+	} else {
+		ok = false;
+	}
+	cdor_tally_free (t);
+	puts (ok ? "OK" : "the tally lost track of the winner");
+	return ok;
+}
+
+static cdor_bool
+test_window (void)
+{
+	/* Two epochs: A > B > C, then C > B > A twice, then B > A > C */
+	const size_t abc[3] = { 0, 1, 2 }, cba[3] = { 2, 1, 0 };
+	const size_t bac[3] = { 1, 0, 2 };
+	struct cdor_window * const v = cdor_window_new (3, 2);
+	cdor_adv expected[9] = { 0 }, batch[9] = { 0 };
+	size_t winner = 3;
+	cdor_bool ok;
+	fputs ("test_window: ", stdout);
+	if (!v) {
+		puts ("could not allocate a window");
+		return false;
+	}
+	cdor_window_ranking (v, abc, 1);
+	ok = cdor_tally_sources (cdor_window_tally (v), &winner) == 1
+	     && winner == 0;
+	cdor_window_advance (v);
+	cdor_cast_weighted_ranking (3, batch, cba, 2);
+	/* A diagonal could never be subtracted from the total */
+	batch[4] = 1;
+	ok = ok && cdor_window_add_duels (v, batch) == -1;
+	batch[4] = 0;
+	ok = ok && cdor_window_add_duels (v, batch) == 0
+	     && cdor_tally_sources (cdor_window_tally (v), &winner) == 1
+	     && winner == 2;
+	/* The first epoch expires */
+	cdor_window_advance (v);
+	cdor_window_ranking (v, bac, 1);
+	cdor_cast_weighted_ranking (3, expected, cba, 2);
+	cdor_cast_weighted_ranking (3, expected, bac, 1);
+	ok = ok && memcmp (cdor_tally_duels (cdor_window_tally (v)), expected,
+	                   sizeof expected) == 0
+	     && cdor_tally_sources (cdor_window_tally (v), &winner) == 1
+	     && winner == 2;
+	/* Then the second, leaving only the last ballot */
+	cdor_window_advance (v);
+	memset (expected, 0, sizeof expected);
+	cdor_cast_weighted_ranking (3, expected, bac, 1);
+	ok = ok && memcmp (cdor_tally_duels (cdor_window_tally (v)), expected,
+	                   sizeof expected) == 0
+	     && cdor_tally_sources (cdor_window_tally (v), &winner) == 1
+	     && winner == 1;
+	cdor_window_free (v);
+	puts (ok ? "OK" : "expired ballots were miscounted");
+	return ok;
+}
+
+static cdor_bool
+test_sample (void)
+{
+	/* 70% of A > B > C and 30% of C > B > A, then half and half */
+	enum { N = 4000 };
+	const size_t abc[3] = { 0, 1, 2 }, cba[3] = { 2, 1, 0 };
+	const char decided[9] = { 0, 1, 1, 0, 0, 1, 0, 0, 0 };
+	const char tied[9] = { 0 };
+	size_t *ranks = malloc (N * 3 * sizeof (size_t)), i, count = 0;
+	struct cdor_sample *s;
+	char graph[9];
+	cdor_bool ok;
+	fputs ("test_sample: ", stdout);
+	if (!ranks) {
+		puts ("could not allocate ballots");
+		return false;
+	}
+	for (i = 0; i < N; i++)
+		memcpy (ranks + i * 3, i % 10 < 7 ? abc : cba, sizeof abc);
+	ok = cdor_sample_ballots (3, N, ranks, 0.01, 1, graph, &count) == 0
+	     && count < N && memcmp (graph, decided, sizeof graph) == 0;
+	for (i = 0; i < N; i++)
+		memcpy (ranks + i * 3, i % 2 ? abc : cba, sizeof abc);
+	ok = ok && cdor_sample_ballots (3, N, ranks, 0.01, 1, graph, &count) == 0
+	     && count == N && memcmp (graph, tied, sizeof graph) == 0;
+	free (ranks);
+	if ((s = cdor_sample_new (3, 1, 0.5))) {
+		ok = ok && cdor_sample_settled (s, NULL) == 0
+		     && cdor_sample_ranking (s, abc) == 0
+		     && cdor_sample_ranking (s, abc) != 0
+		     && cdor_sample_settled (s, graph) == 1
+		     && memcmp (graph, decided, sizeof graph) == 0;
+		cdor_sample_free (s);
+	} else {
+		ok = false;
+	}
+	puts (ok ? "OK" : "the duel graph was not settled correctly");
+	return ok;
+}
+
+static cdor_bool
+test_duel_arith (void)
+{
+	cdor_adv a[4] = { 0, 3, 1, 0 };
+	const cdor_adv b[4] = { 0, 1, 2, 0 }, sum[4] = { 0, 4, 3, 0 };
+	const cdor_adv big[4] = { 0, (cdor_adv) -1, 0, 0 };
+	cdor_bool ok;
+	fputs ("test_duel_arith: ", stdout);
+	ok = cdor_add_duels (2, a, b) == 0 && memcmp (a, sum, sizeof a) == 0;
+	ok = ok && cdor_add_duels (2, a, big) != 0
+	     && memcmp (a, sum, sizeof a) == 0;
+	ok = ok && cdor_subtract_duels (2, a, b) == 0
+	     && cdor_subtract_duels (2, a, b) != 0 && a[1] == 3 && a[2] == 1;
+	ok = ok && cdor_scale_duels (2, a, 2) == 0 && a[1] == 6 && a[2] == 2
+	     && cdor_scale_duels (2, a, (cdor_adv) -1) != 0 && a[1] == 6;
+	puts (ok ? "OK" : "duel matrix arithmetic failed");
+	return ok;
+}
+
+static const size_t margin_rank[4] = { 2, 0, 1, 2 };
+
+static int
+margin_ballot (const size_t i, const size_t j)
+{
+	return (margin_rank[i] < margin_rank[j]) - (margin_rank[j] < margin_rank[i]);
+}
+
+static cdor_bool
+test_margin (void)
+{
+	const size_t other[4] = { 0, 3, 1, 2 };
+	cdor_margin margins[6] = { 0 };
+	cdor_adv duels[16] = { 0 };
+	char graph[16], expected[16];
+	cdor_bool ok;
+	fputs ("test_margin: ", stdout);
+	cdor_cast_margin_ballot (4, margins, margin_ballot);
+	cdor_cast_margin_ranking (4, margins, other, 2);
+	cdor_cast_margin_ranking (4, margins, margin_rank, -1);
+	cdor_cast_margin_ranking (4, margins, margin_rank, 1);
+	cdor_cast_ranking (4, duels, margin_rank);
+	cdor_cast_weighted_ranking (4, duels, other, 2);
+	cdor_make_margin_graph (4, graph, margins);
+	cdor_make_duel_graph (4, expected, duels);
+	ok = cdor_margin_size (4) == 6 && margins[0] == 1 && margins[2] == 2
+	     && memcmp (graph, expected, sizeof graph) == 0;
+	puts (ok ? "OK" : "margin graph does not match duel graph");
+	return ok;
+}
+
+static cdor_bool
+test_batch (void)
+{
+	static const char paradox[9] = { 0, 1, 0, 0, 0, 1, 1, 0, 0 };
+	static const char ladder[9] = { 0, 1, 1, 0, 0, 1, 0, 0, 0 };
+	struct cdor_election elections[40];
+	struct cdor_strategy out[40];
+	size_t i;
+	cdor_bool ok;
+	fputs ("test_batch: ", stdout);
+	for (i = 0; i < 40; i++) {
+		elections[i].nalt = 3;
+		elections[i].graph = i % 2 ? paradox : ladder;
+	}
+	ok = cdor_batch_strategies (40, elections, out, 4) == 0;
+	for (i = 0; i < 40; i++) {
+		if (out[i].type == CDOR_SPARSE) {
+			ok = ok && i % 2 && out[i].val.sparse.len == 3;
+			free (out[i].val.sparse.supp);
+			out[i].type = CDOR_ERROR;
+		} else {
+			ok = ok && !(i % 2) && out[i].type == CDOR_PURE
+			     && out[i].val.pure == 0;
+		}
+	}
+	/* One invalid election fails alone */
+	elections[7].nalt = 0;
+	errno = 0;
+	ok = cdor_batch_strategies (40, elections, out, 4) == -1 && ok;
+#if _POSIX_C_SOURCE >= 1L
+	ok = ok && errno == EINVAL;
+#endif
+	for (i = 0; i < 40; i++) {
+		if (out[i].type == CDOR_SPARSE)
+			free (out[i].val.sparse.supp);
+		ok = ok && (out[i].type == CDOR_ERROR) == (i == 7);
+	}
+	puts (ok ? "OK" : "batch strategies do not match");
+	return ok;
+}
+
+#define STRESS_THREADS 8
+#define STRESS_ROUNDS 50
+
+static const char stress_graph[64] = {
+	0, 1, 0, 0, 0, 0, 0, 0,
+	0, 0, 1, 0, 0, 0, 0, 0,
+	1, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 1, 1, 1, 0,
+	0, 0, 0, 0, 0, 1, 0, 1,
+	0, 0, 0, 0, 0, 0, 1, 1,
+	0, 0, 0, 0, 1, 0, 0, 1,
+	0, 0, 0, 1, 0, 0, 0, 0
+};
+
+/* Solves the same election over and over, counting wrong results */
+static void *
+stress_worker (void * const arg)
+{
+	const double expected[8] = {
+		1.0 / 6.0, 1.0 / 6.0, 1.0 / 6.0, 1.0 / 6.0,
+		1.0 / 18.0, 1.0 / 18.0, 1.0 / 18.0, 1.0 / 6.0
+	};
+	unsigned * const failures = (unsigned *) arg;
+	unsigned k;
+	for (k = 0; k < STRESS_ROUNDS; k++) {
+		struct cdor_strategy r;
+		double dense[8] = { 0.0 };
+		size_t i;
+		if (cdor_compute_strategy (8, stress_graph, &r) != CDOR_OK
+		    || r.type != CDOR_SPARSE) {
+			++*failures;
+			continue;
+		}
+		for (i = 0; i < r.val.sparse.len; i++)
+			dense[r.val.sparse.supp[i].alt] = r.val.sparse.supp[i].prob;
+		free (r.val.sparse.supp);
+		if (!vec_compare (8, dense, expected))
+			++*failures;
+	}
+	return NULL;
+}
+
+static cdor_bool
+test_concurrent_strategies (void)
+{
+	unsigned failures[STRESS_THREADS] = { 0 };
+	unsigned i, total = 0;
+	struct cdor_strategy r;
+	fputs ("test_concurrent_strategies: ", stdout);
+	if (cdor_compute_strategy (0, stress_graph, &r) != CDOR_INVALID
+	    || r.type != CDOR_ERROR) {
+		puts ("empty election was accepted");
+		return false;
+	}
+#ifdef CDOR_THREADS
+	{
+		pthread_t thread[STRESS_THREADS];
+		unsigned started = 0;
+		while (started < STRESS_THREADS
+		       && pthread_create (&thread[started], NULL, stress_worker,
+		                          &failures[started]) == 0)
+			started++;
+		/* Whatever could not be started runs here */
+		for (i = started; i < STRESS_THREADS; i++)
+			stress_worker (&failures[i]);
+		while (started > 0)
+			pthread_join (thread[--started], NULL);
+	}
+#else
+	for (i = 0; i < STRESS_THREADS; i++)
+		stress_worker (&failures[i]);
+#endif
+	for (i = 0; i < STRESS_THREADS; i++)
+		total += failures[i];
+	if (total > 0) {
+		printf ("%u of %u concurrent solutions were wrong\n", total,
+		        STRESS_THREADS * STRESS_ROUNDS);
+		return false;
+	}
+	puts ("OK");
+	return true;
+}
+
+#define SHARED_THREADS 4
+#define SHARED_ROUNDS 2000
+
+#if _POSIX_C_SOURCE >= 200112L
+static const size_t shared_rank[4] = { 0, 1, 2, 3 };
+
+static void *
+shared_worker (void *arg)
+{
+	/* Each worker has its own handle, hence its own stripe */
+	struct cdor_shared * const s = cdor_shared_open ((const char *) arg, 4, 2);
+	unsigned i;
+	if (!s)
+		return arg;
+	for (i = 0; i < SHARED_ROUNDS; i++)
+		cdor_shared_ranking (s, shared_rank, 1);
+	cdor_shared_close (s);
+	return NULL;
+}
+
+/* Whether the snapshot holds a whole number of ballots */
+static cdor_bool
+shared_consistent (const cdor_adv duels[16], const cdor_adv ballots)
+{
+	size_t i, j;
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < 4; j++) {
+			if (duels[i * 4 + j] != (i < j ? ballots : 0))
+				return false;
+		}
+	}
+	return true;
+}
+#endif
+
+static cdor_bool
+test_shared (void)
+{
+#if _POSIX_C_SOURCE >= 200112L
+	char path[] = "/tmp/condor-shared-XXXXXX";
+	struct cdor_shared *s;
+	cdor_adv duels[16];
+	cdor_bool ok = true;
+	unsigned i;
+	int fd;
+	fputs ("test_shared: ", stdout);
+	if ((fd = mkstemp (path)) < 0) {
+		puts ("could not create a file name");
+		return false;
+	}
+	close (fd);
+	unlink (path);
+	if (!(s = cdor_shared_open (path, 4, 2))) {
+		/* Without lock-free atomics, there is nothing to test */
+		ok = errno == ENOSYS;
+		puts (ok ? "OK" : "could not create a shared matrix");
+		return ok;
+	}
+	ok = !cdor_shared_open (path, 3, 2) && errno == EINVAL;
+#ifdef CDOR_THREADS
+	{
+		pthread_t thread[SHARED_THREADS];
+		unsigned started = 0;
+		while (started < SHARED_THREADS
+		       && pthread_create (&thread[started], NULL, shared_worker,
+		                          path) == 0)
+			started++;
+		for (i = started; i < SHARED_THREADS; i++)
+			ok = ok && !shared_worker (path);
+		/* Snapshots taken while casting may only split ballots if told */
+		for (i = 0; i < 100; i++) {
+			const int r = cdor_shared_snapshot (s, duels);
+			ok = ok && r >= 0
+			     && (r > 0 || shared_consistent (duels, duels[1]));
+		}
+		while (started > 0) {
+			void *failed;
+			pthread_join (thread[--started], &failed);
+			ok = ok && !failed;
+		}
+	}
+#else
+	for (i = 0; i < SHARED_THREADS; i++)
+		ok = ok && !shared_worker (path);
+#endif
+	ok = ok && cdor_shared_snapshot (s, duels) == 0
+	     && shared_consistent (duels, SHARED_THREADS * SHARED_ROUNDS);
+	cdor_shared_add_duels (s, duels);
+	ok = ok && cdor_shared_snapshot (s, duels) == 0
+	     && shared_consistent (duels, 2 * SHARED_THREADS * SHARED_ROUNDS);
+	ok = cdor_shared_close (s) == 0 && ok;
+	unlink (path);
+	puts (ok ? "OK" : "concurrent casts were miscounted");
+	return ok;
+#else
+	puts ("test_shared: OK");
+	return true;
+#endif
+}
+
+#if _POSIX_C_SOURCE >= 200112L
+static char *
+condord_u32 (char * const p, const uint32_t x)
+{
+	memcpy (p, &x, sizeof x);
+	return p + sizeof x;
+}
+
+static uint32_t
+condord_get (const char * const p)
+{
+	uint32_t x;
+	memcpy (&x, p, sizeof x);
+	return x;
+}
+
+/* Reads exactly len bytes */
+static cdor_bool
+condord_read (const int fd, char * const buf, const size_t len)
+{
+	size_t got = 0;
+	while (got < len) {
+		const ssize_t n = read (fd, buf + got, len - got);
+		if (n <= 0)
+			return false;
+		got += (size_t) n;
+	}
+	return true;
+}
+
+/* Reads a whole reply and checks its size and status */
+static cdor_bool
+condord_reply (const int fd, char * const buf, const uint32_t size,
+               const uint32_t status)
+{
+	return condord_read (fd, buf, 4 + (size_t) size)
+	       && condord_get (buf) == size && condord_get (buf + 4) == status;
+}
+
+/* Connects to the daemon, giving it a few seconds to start listening */
+static int
+condord_connect (const char * const path)
+{
+	struct sockaddr_un addr;
+	const struct timespec pause = { 0, 10000000 };
+	unsigned tries;
+	memset (&addr, 0, sizeof addr);
+	addr.sun_family = AF_UNIX;
+	strcpy (addr.sun_path, path);
+	for (tries = 0; tries < 500; tries++) {
+		const int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0)
+			return -1;
+		if (connect (fd, (struct sockaddr *) &addr, sizeof addr) == 0)
+			return fd;
+		close (fd);
+		nanosleep (&pause, NULL);
+	}
+	return -1;
+}
+
+static cdor_bool
+condord_send (const int fd, const char * const req, const size_t len)
+{
+	return write (fd, req, len) == (ssize_t) len;
+}
+
+enum { CONDORD_BAD, CONDORD_CYCLE, CONDORD_WINNER };
+
+/*
+ * Reads a strategy among n alternatives and tells whether it is the uniform
+ * one of a cycle among them all or the pure one of alternative 0
+ */
+static int
+condord_strategy (const int fd, char * const buf, const uint32_t n)
+{
+	uint32_t len, i;
+	double prob;
+	if (!condord_read (fd, buf, 12) || condord_get (buf + 4) != CDORD_OK)
+		return CONDORD_BAD;
+	len = condord_get (buf + 8);
+	if (len == 0 || len > n || condord_get (buf) != 8 + 12 * len
+	    || !condord_read (fd, buf + 12, 12 * (size_t) len))
+		return CONDORD_BAD;
+	for (i = 0; i < len; i++) {
+		memcpy (&prob, buf + 16 + 12 * i, sizeof prob);
+		if (condord_get (buf + 12 + 12 * i) >= n
+		    || fabs (prob - 1.0 / (double) len) > 1e-9)
+			return CONDORD_BAD;
+	}
+	if (len == n)
+		return CONDORD_CYCLE;
+	return len == 1 && condord_get (buf + 12) == 0 ? CONDORD_WINNER
+	       : CONDORD_BAD;
+}
+#endif
+
+static cdor_bool
+test_condord (void)
+{
+#if _POSIX_C_SOURCE >= 200112L
+	/* Two ballots, a truncated one, then the strategy and the duels */
+	static const uint32_t ballots[8] = { 2, 0, 1, 2, 1, 1, 2, 0 };
+	static const uint64_t expected[9] = { 0, 3, 2, 0, 0, 2, 1, 1, 0 };
+	char req[80], buf[96], *p = req;
+	void (*pipe_handler) (int);
+	cdor_bool ok;
+	double prob;
+	size_t i;
+	int sv[2], status;
+	pid_t pid;
+	fputs ("test_condord: ", stdout);
+	fflush (stdout);
+	if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+		puts ("could not create sockets");
+		return false;
+	}
+	if ((pid = fork ()) == 0) {
+		dup2 (sv[1], STDIN_FILENO);
+		close (sv[0]);
+		close (sv[1]);
+		execl ("./condord", "condord", "-i", "-n", "3", (char *) NULL);
+		_exit (127);
+	}
+	close (sv[1]);
+	p = condord_u32 (p, 4 + sizeof ballots);
+	p = condord_u32 (p, CDORD_BALLOTS);
+	for (i = 0; i < 8; i++)
+		p = condord_u32 (p, ballots[i]);
+	p = condord_u32 (p, 8);
+	p = condord_u32 (p, CDORD_BALLOTS);
+	p = condord_u32 (p, 1);
+	p = condord_u32 (p, 4);
+	p = condord_u32 (p, CDORD_STRATEGY);
+	p = condord_u32 (p, 4);
+	p = condord_u32 (p, CDORD_DUELS);
+	/* The daemon may be gone if it could not be run */
+	pipe_handler = signal (SIGPIPE, SIG_IGN);
+	ok = pid > 0 && write (sv[0], req, (size_t) (p - req))
+	                == (ssize_t) (p - req);
+	signal (SIGPIPE, pipe_handler);
+	ok = ok && condord_reply (sv[0], buf, 8, CDORD_OK)
+	     && condord_get (buf + 8) == 2;
+	ok = ok && condord_reply (sv[0], buf, 8, CDORD_INVALID)
+	     && condord_get (buf + 8) == 0;
+	/* The first alternative is the Condorcet winner */
+	ok = ok && condord_reply (sv[0], buf, 20, CDORD_OK)
+	     && condord_get (buf + 8) == 1 && condord_get (buf + 12) == 0;
+	if (ok) {
+		memcpy (&prob, buf + 16, sizeof prob);
+		ok = prob == 1.0;
+	}
+	ok = ok && condord_reply (sv[0], buf, 80, CDORD_OK)
+	     && condord_get (buf + 8) == 3;
+	for (i = 0; ok && i < 9; i++) {
+		uint64_t x;
+		memcpy (&x, buf + 12 + 8 * i, sizeof x);
+		ok = x == expected[i];
+	}
+	/* Hanging up stops the daemon */
+	close (sv[0]);
+	if (pid > 0)
+		ok = waitpid (pid, &status, 0) == pid && ok && WIFEXITED(status)
+		     && WEXITSTATUS(status) == 0;
+	puts (ok ? "OK" : "the daemon did not answer as expected");
+	return ok;
+#else
+	puts ("test_condord: OK");
+	return true;
+#endif
+}
+
+
+#define RESUME_N 61
+
+static cdor_bool
+test_condord_resume (void)
+{
+#if _POSIX_C_SOURCE >= 200112L
+	const size_t ballot = 4 * (RESUME_N + 1);
+	char path[] = "/tmp/condord-XXXXXX", *req, *buf, *p;
+	cdor_bool ok;
+	size_t i, k;
+	int a = -1, b = -1, fd, status;
+	pid_t pid;
+	fputs ("test_condord_resume: ", stdout);
+	fflush (stdout);
+	if ((fd = mkstemp (path)) < 0) {
+		puts ("could not create a file name");
+		return false;
+	}
+	close (fd);
+	unlink (path);
+	req = allocate(char, 16 + RESUME_N * ballot);
+	buf = allocate(char, 12 + 8 * RESUME_N * RESUME_N);
+	if (!req || !buf) {
+		free (req);
+		free (buf);
+		puts ("out of memory");
+		return false;
+	}
+	if ((pid = fork ()) == 0) {
+		execl ("./condord", "condord", "-n", "61", path, (char *) NULL);
+		_exit (127);
+	}
+	ok = pid > 0 && (a = condord_connect (path)) >= 0
+	     && (b = condord_connect (path)) >= 0;
+	/* A cycle among every alternative, whose solve takes a while */
+	p = condord_u32 (req, (uint32_t) (4 + RESUME_N * ballot));
+	p = condord_u32 (p, CDORD_BALLOTS);
+	for (k = 0; k < RESUME_N; k++) {
+		p = condord_u32 (p, 1);
+		for (i = 0; i < RESUME_N; i++)
+			p = condord_u32 (p, (uint32_t) ((i + RESUME_N - k)
+			                                % RESUME_N));
+	}
+	p = condord_u32 (p, 4);
+	p = condord_u32 (p, CDORD_STRATEGY);
+	ok = ok && condord_send (a, req, (size_t) (p - req));
+	/* Once the cycle is counted, its solve has started */
+	p = condord_u32 (req, 4);
+	p = condord_u32 (p, CDORD_DUELS);
+	for (k = 0; ok && k < 1000; k++) {
+		uint64_t x;
+		ok = condord_send (b, req, 8)
+		     && condord_reply (b, buf, 8 + 8 * RESUME_N * RESUME_N,
+		                       CDORD_OK);
+		memcpy (&x, buf + 20, sizeof x);
+		if (x != 0)
+			break;
+	}
+	/* The second client makes 0 the winner while the cycle is solved */
+	p = condord_u32 (req, (uint32_t) (4 + ballot));
+	p = condord_u32 (p, CDORD_BALLOTS);
+	p = condord_u32 (p, 1000);
+	for (i = 0; i < RESUME_N; i++)
+		p = condord_u32 (p, i > 0);
+	p = condord_u32 (p, 4);
+	p = condord_u32 (p, CDORD_STRATEGY);
+	ok = ok && condord_send (b, req, (size_t) (p - req));
+	ok = ok && condord_reply (b, buf, 8, CDORD_OK)
+	     && condord_get (buf + 8) == 1
+	     && condord_strategy (b, buf, RESUME_N) == CONDORD_WINNER;
+	/* The first client may have been answered before the new ballots */
+	ok = ok && condord_reply (a, buf, 8, CDORD_OK)
+	     && condord_get (buf + 8) == RESUME_N
+	     && condord_strategy (a, buf, RESUME_N) != CONDORD_BAD;
+	if (a >= 0)
+		close (a);
+	if (b >= 0)
+		close (b);
+	if (pid > 0) {
+		kill (pid, SIGTERM);
+		ok = waitpid (pid, &status, 0) == pid && ok && WIFEXITED(status)
+		     && WEXITSTATUS(status) == 0;
+	}
+	unlink (path);
+	free (req);
+	free (buf);
+	puts (ok ? "OK" : "waiting clients were not answered as expected");
+	return ok;
+#else
+	puts ("test_condord_resume: OK");
+	return true;
+#endif
+}
+
 int
 main (void)
 {
@@ -358,7 +1596,32 @@ main (void)
 		test_5uniform,
 		test_5heterogen,
 		test_two_paradox,
-		test_paradox_plus_5
+		test_paradox_plus_5,
+		test_sparse_sources,
+		test_sparse_paradox_plus_5,
+		test_snapshot_roundtrip,
+		test_snapshot_delta,
+		test_ingest,
+		test_ballot_set,
+		test_partial_ranking,
+		test_tally,
+		test_window,
+		test_sample,
+		test_duel_arith,
+		test_margin,
+		test_batch,
+		test_strategy_cache,
+		test_small_ties,
+		test_approx_strategy,
+		test_strided_graph,
+		test_tiled_graph,
+		test_duels_strategy,
+		test_presolve,
+		test_check_strategy,
+		test_concurrent_strategies,
+		test_shared,
+		test_condord,
+		test_condord_resume
 	};
 	size_t i;
 	cdor_bool all_good = true;
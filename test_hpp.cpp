@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ * 
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ * 
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "condor.hpp"
+
+static bool
+test_cast_safe (void)
+{
+	cdor::duel_matrix m (4);
+	bool ok;
+	std::fputs ("test_cast_safe: ", stdout);
+	m.cast ([](const size_t i, const size_t j) {
+		return i < j ? 1 : -1;
+	}, 3);
+	const cdor::duel_matrix before = m;
+	unsigned calls = 0;
+	try {
+		// Increments several cells before failing
+		m.cast_safe ([&calls](const size_t i, const size_t j) -> int {
+			if (++calls == 5)
+				throw std::runtime_error ("bad ballot");
+			return i > j ? 1 : 0;
+		}, 7);
+		ok = false;
+	} catch (const std::runtime_error &) {
+		ok = calls == 5;
+	}
+	ok = ok && std::equal (m.data (), m.data () + 16, before.data ());
+	// A complete cast still counts
+	m.cast_safe ([](const size_t i, const size_t j) {
+		return i > j ? 1 : 0;
+	}, 2);
+	ok = ok && m (1, 0) == 2 && m (0, 1) == 3 && m (3, 2) == 2;
+	std::puts (ok ? "OK" : "a failed cast changed the matrix");
+	return ok;
+}
+
+static bool
+test_philox (void)
+{
+	// Known answers of Philox4x32-10 from Random123: counter, key, output
+	struct answer {
+		uint64_t lo, hi, seed;
+		cdor::philox::result_type out;
+	};
+	static const answer known[3] = {
+		{ 0, 0, 0, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+		{
+			0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff,
+			{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd }
+		},
+		{
+			0x85a308d3243f6a88, 0x0370734413198a2e, 0x299f31d0a4093822,
+			{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }
+		}
+	};
+	bool ok = true;
+	std::fputs ("test_philox: ", stdout);
+	for (const answer &a : known)
+		ok = ok && cdor::philox (a.seed) (a.lo, a.hi) == a.out;
+	std::puts (ok ? "OK" : "outputs differ from the reference");
+	return ok;
+}
+
+static cdor::duel_graph
+paradox (void)
+{
+	cdor::duel_graph g (3);
+	g (0, 1) = 1;
+	g (1, 2) = 1;
+	g (2, 0) = 1;
+	return g;
+}
+
+static bool
+test_sampler (void)
+{
+	// Draws of the paradox strategy with seed 42 in stream 7
+	static const size_t expected[16] = {
+		1, 1, 2, 1, 0, 1, 1, 1,
+		2, 1, 0, 1, 0, 0, 2, 0
+	};
+	const cdor::sampler s {cdor::strategy (paradox ())};
+	std::vector<size_t> whole, split;
+	bool ok;
+	std::fputs ("test_sampler: ", stdout);
+	s.generate (42, 7, 0, 16, std::back_inserter (whole));
+	ok = std::equal (whole.cbegin (), whole.cend (), expected);
+	// Draws only depend on their number, however they are split
+	s.generate (42, 7, 0, 5, std::back_inserter (split));
+	s.generate (42, 7, 5, 11, std::back_inserter (split));
+	ok = ok && split == whole;
+	const std::vector<uint64_t> h1 = s.histogram (42, 7, 100000, 1);
+	const std::vector<uint64_t> h4 = s.histogram (42, 7, 100000, 4);
+	ok = ok && h1 == h4 && h1[0] + h1[1] + h1[2] == 100000;
+	for (const uint64_t c : h1)
+		ok = ok && c > 32000 && c < 34700;
+	std::puts (ok ? "OK" : "draws differ from the reference");
+	return ok;
+}
+
+static bool
+test_service (void)
+{
+	std::vector<cdor::strategy_service::task> tasks;
+	cdor::strategy_service svc ([&tasks](cdor::strategy_service::task t) {
+		tasks.push_back (std::move (t));
+	});
+	cdor::duel_graph winner (3);
+	winner (1, 0) = 1;
+	winner (1, 2) = 1;
+	bool ok;
+	std::fputs ("test_service: ", stdout);
+	// Requests for the same graph share one task
+	cdor::strategy_service::request a = svc.submit (paradox ());
+	cdor::strategy_service::request b = svc.submit (paradox ());
+	cdor::strategy_service::request c = svc.submit (winner);
+	ok = tasks.size () == 2;
+	for (const auto &t : tasks)
+		t ();
+	tasks.clear ();
+	ok = ok && a.get ().is_mixed () && b.get ().is_mixed ()
+	     && c.get ().is_pure () && c.get ()[1] == 1;
+	// Once solved, the graph is solved again
+	cdor::strategy_service::request d = svc.submit (paradox ());
+	ok = ok && tasks.size () == 1;
+	tasks.front () ();
+	tasks.clear ();
+	ok = ok && d.get ().is_mixed ();
+	// The default executor runs tasks on its own thread
+	cdor::strategy_service def;
+	ok = ok && def.submit (paradox ()).get ().is_mixed ();
+	std::puts (ok ? "OK" : "requests were not coalesced");
+	return ok;
+}
+
+static bool
+test_service_cancel (void)
+{
+	std::vector<cdor::strategy_service::task> tasks;
+	cdor::strategy_service svc ([&tasks](cdor::strategy_service::task t) {
+		tasks.push_back (std::move (t));
+	});
+	bool ok = true;
+	std::fputs ("test_service_cancel: ", stdout);
+	// The task still runs for the remaining request
+	cdor::strategy_service::request a = svc.submit (paradox ());
+	cdor::strategy_service::request b = svc.submit (paradox ());
+	a.cancel ();
+	a.cancel ();
+	tasks.front () ();
+	tasks.clear ();
+	ok = ok && b.get ().is_mixed ();
+	// Cancelled or destroyed, no request waits any more
+	std::shared_future<cdor::strategy> f;
+	{
+		cdor::strategy_service::request c = svc.submit (paradox ());
+		cdor::strategy_service::request d = svc.submit (paradox ());
+		c.cancel ();
+		f = d.future ();
+	}
+	tasks.front () ();
+	tasks.clear ();
+	try {
+		f.get ();
+		ok = false;
+	} catch (const cdor::strategy_cancelled &) {
+	}
+	std::puts (ok ? "OK" : "cancelled requests were computed");
+	return ok;
+}
+
+static bool
+test_service_throw (void)
+{
+	cdor::strategy_service *self = nullptr;
+	std::vector<cdor::strategy_service::request> joined;
+	bool fail = true;
+	cdor::strategy_service svc ([&](cdor::strategy_service::task t) {
+		if (!fail) {
+			t ();
+			return;
+		}
+		// Joins the job before the executor reports failing to run it
+		joined.push_back (self->submit (paradox ()));
+		throw std::runtime_error ("no room");
+	});
+	bool ok = false;
+	self = &svc;
+	std::fputs ("test_service_throw: ", stdout);
+	try {
+		svc.submit (paradox ());
+	} catch (const std::runtime_error &) {
+		ok = true;
+	}
+	try {
+		ok = ok && joined.size () == 1;
+		joined.front ().get ();
+		ok = false;
+	} catch (const std::runtime_error &e) {
+		ok = ok && std::string (e.what ()) == "no room";
+	}
+	// The failed job is forgotten
+	fail = false;
+	ok = ok && svc.submit (paradox ()).get ().is_mixed ();
+	std::puts (ok ? "OK" : "a failed submission left requests waiting");
+	return ok;
+}
+
+int
+main (void)
+{
+	bool (*test[])(void) = {
+		test_cast_safe,
+		test_philox,
+		test_sampler,
+		test_service,
+		test_service_cancel,
+		test_service_throw
+	};
+	bool all_good = true;
+	for (const auto t : test)
+		all_good &= t ();
+	if (all_good) {
+		std::puts ("All tests succeeded!");
+		return EXIT_SUCCESS;
+	} else {
+		std::puts ("One or more tests failed");
+		return EXIT_FAILURE;
+	}
+}
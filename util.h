@@ -36,6 +36,21 @@
 
 #define zero_allocate(T, n) ((T *) calloc (n, sizeof (T)))
 
+/* Macro for setting errno to a POSIX value when available */
+#if _POSIX_C_SOURCE >= 1L
+#define set_errno(e) ((void) (errno = (e)))
+#else
+#define set_errno(e) ((void) 0)
+#endif
+
+/* Macro for POSIX threads support */
+#if _POSIX_C_SOURCE >= 200112L
+#include <unistd.h>
+#if defined _POSIX_THREADS && _POSIX_THREADS > 0
+#define CDOR_THREADS 1
+#endif
+#endif
+
 /* Custom boolean type to accomodate C89 */
 #if __STDC_VERSION__ >= 199901L
 typedef bool cdor_bool;
@@ -44,4 +59,15 @@ typedef char cdor_bool;
 enum { false, true };
 #endif
 
+/* Functions shared between translation units but not part of the API */
+#ifdef CONDOR_H_INCLUDED
+extern struct cdor_strategy cdor_strategy_scratch (size_t, const char *,
+                                                   cdor_bool *,
+                                                   enum cdor_status *);
+extern cdor_bool cdor_table_strategy (size_t, const char *,
+                                      struct cdor_strategy *);
+extern const size_t cdor_table_max;
+extern void cdor_status_errno (enum cdor_status);
+#endif
+
 #endif /* UTIL_H_INCLUDED */
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2024 Pierre Colin
+ * This file is part of Condor.
+ *
+ * Condor is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * Condor is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Condor.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "condor.h"
+#include "util.h"
+
+/*
+ * A window keeps one advantage graph per epoch in a ring, the current epoch
+ * being the one ballots go to, and the total of the window in a tally.  Casts
+ * go both to the current epoch and the tally.  Advancing subtracts the oldest
+ * epoch from the tally and reuses it as the new current one, so the total is
+ * never recomputed from the epochs.
+ */
+struct cdor_window {
+	size_t nalt;
+	size_t nepochs;
+	size_t current;
+	cdor_adv *epochs;
+	struct cdor_tally *total;
+};
+
+static cdor_adv *
+window_epoch (const struct cdor_window REF(w), const size_t e)
+{
+	return w->epochs + e * w->nalt * w->nalt;
+}
+
+struct cdor_window *
+cdor_window_new (const size_t nalt, const size_t nepochs)
+{
+	struct cdor_window *w;
+	if (nalt == 0 || nepochs == 0 || nalt > (size_t) -1 / nalt
+	    || nepochs > (size_t) -1 / sizeof (cdor_adv) / nalt / nalt) {
+		set_errno (EINVAL);
+		return NULL;
+	}
+	if (!(w = allocate(struct cdor_window, 1)))
+		return NULL;
+	w->nalt = nalt;
+	w->nepochs = nepochs;
+	w->current = 0;
+	w->epochs = zero_allocate(cdor_adv, nepochs * nalt * nalt);
+	w->total = cdor_tally_new (nalt, NULL);
+	if (!w->epochs || !w->total) {
+		cdor_window_free (w);
+		return NULL;
+	}
+	return w;
+}
+
+void
+cdor_window_free (struct cdor_window * const w)
+{
+	if (!w)
+		return;
+	cdor_tally_free (w->total);
+	free (w->epochs);
+	free (w);
+}
+
+void
+cdor_window_ranking (struct cdor_window * CDOR_RESTRICT const w,
+                     const size_t * CDOR_RESTRICT rank, const cdor_adv weight)
+{
+	cdor_cast_weighted_ranking (w->nalt, window_epoch (w, w->current), rank,
+	                            weight);
+	cdor_tally_ranking (w->total, rank, weight);
+}
+
+void
+cdor_window_partial_ranking (struct cdor_window * CDOR_RESTRICT const w,
+                             const size_t len,
+                             const size_t * CDOR_RESTRICT alt,
+                             const size_t * CDOR_RESTRICT rank,
+                             const cdor_adv weight)
+{
+	cdor_cast_partial_ranking (w->nalt, window_epoch (w, w->current), len,
+	                           alt, rank, weight);
+	cdor_tally_partial_ranking (w->total, len, alt, rank, weight);
+}
+
+int
+cdor_window_add_duels (struct cdor_window * CDOR_RESTRICT const w,
+                       const cdor_adv * CDOR_RESTRICT const duels)
+{
+	cdor_adv * const epoch = window_epoch (w, w->current);
+	size_t i;
+	/* Epochs must stay part of the total, which has no diagonal */
+	for (i = 0; i < w->nalt; i++) {
+		if (duels[i * w->nalt + i] != 0) {
+			set_errno (EINVAL);
+			return -1;
+		}
+	}
+	/* The epoch is part of the total, so it cannot overflow alone */
+	if (cdor_tally_add_duels (w->total, duels) != 0)
+		return -1;
+	return cdor_add_duels (w->nalt, epoch, duels);
+}
+
+void
+cdor_window_advance (struct cdor_window * const w)
+{
+	cdor_adv *epoch;
+	int status;
+	w->current = (w->current + 1) % w->nepochs;
+	epoch = window_epoch (w, w->current);
+	/* Cannot fail since the total includes the epoch */
+	status = cdor_tally_subtract_duels (w->total, epoch);
+	assert(status == 0);
+	(void) status;
+	memset (epoch, 0, w->nalt * w->nalt * sizeof (cdor_adv));
+}
+
+const struct cdor_tally *
+cdor_window_tally (const struct cdor_window * const w)
+{
+	return w->total;
+}